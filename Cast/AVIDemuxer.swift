@@ -0,0 +1,253 @@
+//
+//  AVIDemuxer.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// Splits an AVI file into H.264 and AAC frames as it streams in.
+///
+/// The RIFF tree is walked in order: `hdrl` says what each stream is, and
+/// `movi` chunks are frames of the first video and first audio stream.
+/// Index chunks and anything else are skipped without being held. AVI has
+/// no timestamps, so frames are timed by their count; files with B-frames
+/// will show them in decode order.
+final class AVIDemuxer: MediaDemuxer {
+
+    private struct Stream {
+        /// `vids`, `auds` or something neither.
+        var type = ""
+        var scale = 1
+        var rate = 1
+        var format: [UInt8] = []
+        var frames: Int64 = 0
+    }
+
+    /// Lists walked into rather than skipped.
+    private static let containers: Set<String> = ["AVI ", "AVIX", "hdrl", "strl", "movi", "rec "]
+
+    //MARK: Properties
+    private var buffer: [UInt8] = []
+    private var skipping = 0
+    private var streams: [Stream] = []
+    private var videoIndex: Int?
+    private var audioIndex: Int?
+    private var inMovie = false
+    /// Length prefix size when frames are stored as `avc1`, nil for Annex B.
+    private var lengthSize: Int?
+    private var sps: [UInt8]?
+    private var pps: [UInt8]?
+    private var videoConfigured = false
+    private var audioConfig: AudioConfig?
+    private var audioFrames: Int64 = 0
+
+    //MARK: MediaDemuxer
+    func append(_ data: Data) -> [DemuxEvent] {
+        buffer.append(contentsOf: data)
+        var events: [DemuxEvent] = []
+        var offset = 0
+        while true {
+            if skipping > 0 {
+                let skipped = min(skipping, buffer.count - offset)
+                skipping -= skipped
+                offset += skipped
+                if skipping > 0 {
+                    break
+                }
+            }
+            guard offset + 8 <= buffer.count else {
+                break
+            }
+            let id = Bytes.fourCC(buffer, offset)
+            let size = Bytes.littleUInt32(buffer, offset + 4)
+            let padded = size + size & 1
+
+            if id == "RIFF" || id == "LIST" {
+                guard offset + 12 <= buffer.count else {
+                    break
+                }
+                let type = Bytes.fourCC(buffer, offset + 8)
+                if AVIDemuxer.containers.contains(type) {
+                    if type == "movi" && !inMovie {
+                        inMovie = true
+                        events += start()
+                    }
+                    offset += 12
+                } else {
+                    offset += 8
+                    skipping = padded
+                }
+                continue
+            }
+            guard isWanted(id) else {
+                offset += 8
+                skipping = padded
+                continue
+            }
+            guard offset + 8 + padded <= buffer.count else {
+                break
+            }
+            let body = Array(buffer[(offset + 8)..<(offset + 8 + size)])
+            events += chunk(id, body)
+            offset += 8 + padded
+        }
+        buffer.removeFirst(offset)
+        return events
+    }
+
+    func finish() -> [DemuxEvent] {
+        return []
+    }
+
+    //MARK: Chunks
+    private func isWanted(_ id: String) -> Bool {
+        if id == "strh" || id == "strf" {
+            return true
+        }
+        guard inMovie, let index = Int(String(id.characters.prefix(2))) else {
+            return false
+        }
+        return index == videoIndex || index == audioIndex
+    }
+
+    private func chunk(_ id: String, _ body: [UInt8]) -> [DemuxEvent] {
+        switch id {
+        case "strh" where body.count >= 28:
+            // Every stream is kept, wanted or not, so frame chunk numbers match.
+            var stream = Stream()
+            stream.type = Bytes.fourCC(body, 0)
+            stream.scale = max(Bytes.littleUInt32(body, 20), 1)
+            stream.rate = max(Bytes.littleUInt32(body, 24), 1)
+            streams.append(stream)
+            return []
+        case "strf":
+            if !streams.isEmpty {
+                streams[streams.count - 1].format = body
+            }
+            return []
+        default:
+            guard let index = Int(String(id.characters.prefix(2))), index < streams.count else {
+                return []
+            }
+            defer {
+                streams[index].frames += 1
+            }
+            return index == videoIndex ? video(body, stream: streams[index]) : audio(body)
+        }
+    }
+
+    /// Picks the streams once the headers are all in.
+    private func start() -> [DemuxEvent] {
+        var events: [DemuxEvent] = []
+        var unsupported: [String] = []
+        for (index, stream) in streams.enumerated() {
+            let format = stream.format
+            if stream.type == "vids" && videoIndex == nil && format.count >= 40 {
+                let compression = Bytes.fourCC(format, 16).uppercased()
+                guard ["H264", "X264", "AVC1", "DAVC"].contains(compression) else {
+                    unsupported.append("AVI video \(compression)")
+                    continue
+                }
+                videoIndex = index
+                let headerSize = min(max(Bytes.littleUInt32(format, 0), 40), format.count)
+                let extra = Array(format[headerSize..<format.count])
+                if extra.first == 1, let sps = H264.sequenceParameterSet(inDecoderConfiguration: extra) {
+                    lengthSize = Int(extra[4] & 0x03) + 1
+                    videoConfigured = true
+                    let size = H264.dimensions(ofSequenceParameterSet: sps)
+                    events.append(.videoConfig(VideoConfig(avcC: extra, width: size?.width ?? Bytes.littleUInt32(format, 4), height: size?.height ?? Bytes.littleUInt32(format, 8))))
+                }
+            } else if stream.type == "auds" && audioIndex == nil && format.count >= 16 {
+                let tag = Bytes.littleUInt16(format, 0)
+                switch tag {
+                case 0xff:
+                    // Raw frames; the configuration follows the header.
+                    audioIndex = index
+                    let extraSize = format.count >= 18 ? Bytes.littleUInt16(format, 16) : 0
+                    if extraSize > 0 && format.count >= 18 + extraSize, let config = AAC.configuration(Array(format[18..<(18 + extraSize)])) {
+                        audioConfig = config
+                        events.append(.audioConfig(config))
+                    }
+                case 0x1600, 0x1601:
+                    // ADTS; the configuration comes with the first frame.
+                    audioIndex = index
+                default:
+                    unsupported.append(String(format: "AVI audio 0x%04x", tag))
+                }
+            }
+        }
+        if videoIndex == nil && audioIndex == nil {
+            return [.unsupported(unsupported.isEmpty ? "no H.264 or AAC streams" : unsupported.joined(separator: ", "))]
+        }
+        return [.tracks(video: videoIndex != nil, audio: audioIndex != nil)] + events
+    }
+
+    private func video(_ body: [UInt8], stream: Stream) -> [DemuxEvent] {
+        let time = stream.frames * Int64(stream.scale) * 90000 / Int64(stream.rate)
+        if body.isEmpty {
+            // A dropped frame still takes its slot.
+            return []
+        }
+        if let lengthSize = lengthSize {
+            let keyframe = H264.containsIDR(lengthPrefixed: body, lengthSize: lengthSize)
+            return [.sample(MediaSample(isVideo: true, data: body, decodeTime: time, compositionOffset: 0, isKeyframe: keyframe))]
+        }
+
+        var events: [DemuxEvent] = []
+        var units: [ArraySlice<UInt8>] = []
+        var keyframe = false
+        for unit in H264.nalUnits(inAnnexB: body) {
+            switch H264.type(of: unit) {
+            case 7:
+                sps = sps ?? Array(unit)
+            case 8:
+                pps = pps ?? Array(unit)
+            case 9:
+                break
+            case 5:
+                keyframe = true
+                units.append(unit)
+            default:
+                units.append(unit)
+            }
+        }
+        if !videoConfigured, let sps = sps, let pps = pps {
+            videoConfigured = true
+            guard let avcC = H264.decoderConfiguration(sps: sps, pps: pps) else {
+                return [.unsupported("malformed H.264 parameter sets")]
+            }
+            let size = H264.dimensions(ofSequenceParameterSet: sps)
+            events.append(.videoConfig(VideoConfig(avcC: avcC, width: size?.width ?? 0, height: size?.height ?? 0)))
+        }
+        if !units.isEmpty {
+            events.append(.sample(MediaSample(isVideo: true, data: H264.lengthPrefixed(units), decodeTime: time, compositionOffset: 0, isKeyframe: keyframe)))
+        }
+        return events
+    }
+
+    private func audio(_ body: [UInt8]) -> [DemuxEvent] {
+        var events: [DemuxEvent] = []
+        var frames = [body]
+        if body.count > 1 && body[0] == 0xff && body[1] & 0xf0 == 0xf0 {
+            let parsed = AAC.frames(inADTS: body)
+            frames = parsed.frames
+            if audioConfig == nil, let config = parsed.config {
+                audioConfig = config
+                events.append(.audioConfig(config))
+            }
+        }
+        guard let sampleRate = audioConfig?.sampleRate else {
+            return events
+        }
+        // Counted in AAC frames rather than chunks, as a chunk may hold several.
+        for frame in frames where !frame.isEmpty {
+            let time = audioFrames * 1024 * 90000 / Int64(sampleRate)
+            audioFrames += 1
+            events.append(.sample(MediaSample(isVideo: false, data: frame, decodeTime: time, compositionOffset: 0, isKeyframe: true)))
+        }
+        return events
+    }
+}
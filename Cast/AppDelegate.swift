@@ -16,13 +16,33 @@ class AppDelegate: UIResponder, UIApplicationDelegate {
 
     func application(_ application: UIApplication, didFinishLaunchingWithOptions launchOptions: [UIApplicationLaunchOptionsKey: Any]?) -> Bool {
         // Override point for customization after application launch.
+        let launchedAt = CACurrentMediaTime()
         
         let castOptions = GCKCastOptions(receiverApplicationID: kGCKMediaDefaultReceiverApplicationID)
         castOptions.physicalVolumeButtonsWillControlDeviceVolume = true
+        castOptions.disableDiscoveryAutostart = true
         
         GCKCastContext.setSharedInstanceWith(castOptions)
+        ManualDeviceProvider.shared.castOptions = castOptions
+        GCKCastContext.sharedInstance().register(ManualDeviceProvider.shared)
 
         GCKCastContext.sharedInstance().useDefaultExpandedMediaControls = true
+        DiscoveryBatcher.shared.start()
+        DeviceCache.shared.start()
+        DiscoveryPolicy.shared.start()
+        DeviceProber.shared.start()
+        MediaStatusHub.shared.start()
+        PlaybackClock.shared.start()
+        SeekEngine.shared.start()
+        ReceiverPrewarmer.shared.start()
+        SessionResumer.shared.start(launchedAt: launchedAt)
+        if LocalMediaServer.shared.start() {
+            LocalMediaServer.shared.publishDocuments()
+        }
+        WebCookieBridge.shared.start()
+        MediaProxy.shared.start()
+        SegmentPrefetcher.shared.start()
+        VariantPolicy.shared.start()
         
         let appStoryboard = UIStoryboard(name: "Main", bundle: nil)
         let navigationController = appStoryboard.instantiateInitialViewController()
@@ -43,10 +63,13 @@ class AppDelegate: UIResponder, UIApplicationDelegate {
     func applicationDidEnterBackground(_ application: UIApplication) {
         // Use this method to release shared resources, save user data, invalidate timers, and store enough application state information to restore your application to its current state in case it is terminated later.
         // If your application supports background execution, this method is called instead of applicationWillTerminate: when the user quits.
+        SessionResumer.shared.savePosition()
     }
 
     func applicationWillEnterForeground(_ application: UIApplication) {
         // Called as part of the transition from the background to the active state; here you can undo many of the changes made on entering the background.
+        // Files may have been added through iTunes file sharing in the meantime.
+        LocalMediaServer.shared.publishDocuments()
     }
 
     func applicationDidBecomeActive(_ application: UIApplication) {
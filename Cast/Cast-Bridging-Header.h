@@ -0,0 +1,9 @@
+//
+//  Cast-Bridging-Header.h
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+#import <CommonCrypto/CommonHMAC.h>
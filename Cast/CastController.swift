@@ -0,0 +1,85 @@
+//
+//  CastController.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import GoogleCast
+
+/// Single entry point for sending media to the connected receiver.
+final class CastController {
+
+    static let shared = CastController()
+
+    /// Seconds before the end of an item at which the receiver starts
+    /// buffering the next one in the queue.
+    static let preloadTime: TimeInterval = 20
+
+    //MARK: Properties
+    var remoteMediaClient: GCKRemoteMediaClient? {
+        return GCKCastContext.sharedInstance().sessionManager.currentCastSession?.remoteMediaClient
+    }
+
+    //MARK: Methods
+
+    /// Loads the cached media information of `item` on the current session.
+    func load(_ item: MediaItem, completion: CastRequestTracker.Completion? = nil) {
+        load(MediaInformationCache.shared.information(for: item), completion: ReceiverPrewarmer.shared.timingFirstLoad(of: item, completion))
+    }
+
+    func load(_ information: GCKMediaInformation, autoplay: Bool = true, playPosition: TimeInterval = 0, completion: CastRequestTracker.Completion? = nil) {
+        QueueWindowManager.shared.stop()
+        CastRequestTracker.shared.issue(.load, send: { [weak self] in
+            self?.remoteMediaClient?.loadMedia(information, autoplay: autoplay, playPosition: playPosition)
+        }, completion: completion)
+    }
+
+    /// Loads `items` as one receiver-side queue. Every item carries a preload
+    /// time, so the receiver fetches the next item while the current one is
+    /// still playing instead of starting it cold. Playlists longer than the
+    /// queue window are handed to `QueueWindowManager`.
+    func loadQueue(_ items: [MediaItem], startIndex: Int = 0, completion: CastRequestTracker.Completion? = nil) {
+        guard let client = remoteMediaClient, !items.isEmpty else {
+            completion?(.failed(CastRequestError.notConnected))
+            return
+        }
+        let completion = ReceiverPrewarmer.shared.timingFirstLoad(of: items.indices.contains(startIndex) ? items[startIndex] : nil, completion)
+        let manager = QueueWindowManager.shared
+        if items.count > manager.radius * 2 + 1 {
+            manager.start(items, startIndex: startIndex, on: client, completion: completion)
+            return
+        }
+        manager.stop()
+        let queueItems = items.map { makeQueueItem(for: $0) }
+        CastRequestTracker.shared.issue(.queueLoad, send: { [weak self] in
+            self?.remoteMediaClient?.queueLoadItems(queueItems, startIndex: UInt(startIndex), repeatMode: .off)
+        }, completion: completion)
+    }
+
+    func requestStatus(completion: CastRequestTracker.Completion? = nil) {
+        CastRequestTracker.shared.issue(.status, send: { [weak self] in
+            self?.remoteMediaClient?.requestStatus()
+        }, completion: completion)
+    }
+
+    /// Shows the subtitle track `trackID` of the current media, or none for
+    /// nil. Switches on the receiver without reloading.
+    func setActiveSubtitle(_ trackID: Int?, completion: CastRequestTracker.Completion? = nil) {
+        let trackIDs = trackID.map { [NSNumber(value: $0)] } ?? []
+        CastRequestTracker.shared.issue(.setActiveTracks, send: { [weak self] in
+            self?.remoteMediaClient?.setActiveTrackIDs(trackIDs)
+        }, completion: completion)
+    }
+
+    func makeQueueItem(for item: MediaItem, customData: Any? = nil) -> GCKMediaQueueItem {
+        let builder = GCKMediaQueueItemBuilder()
+        builder.mediaInformation = MediaInformationCache.shared.information(for: item)
+        builder.autoplay = true
+        builder.preloadTime = CastController.preloadTime
+        builder.customData = customData
+        return builder.build()
+    }
+}
@@ -0,0 +1,353 @@
+//
+//  CastRequestTracker.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+import GoogleCast
+
+enum CastCommand: String {
+    case load
+    case queueLoad
+    case queueInsert
+    case queueRemove
+    case seek
+    case play
+    case pause
+    case stop
+    case status
+    case setActiveTracks
+
+    /// Commands the receiver answers without touching the network or the
+    /// decoder, whose latency is therefore close to one round trip.
+    var isLightweight: Bool {
+        switch self {
+        case .status, .play, .pause:
+            return true
+        default:
+            return false
+        }
+    }
+
+    /// Commands that leave the receiver in the same state however often they
+    /// are sent, and are therefore safe to retry.
+    var isIdempotent: Bool {
+        switch self {
+        case .seek, .play, .pause, .stop, .status, .setActiveTracks:
+            return true
+        case .load, .queueLoad, .queueInsert, .queueRemove:
+            return false
+        }
+    }
+}
+
+enum CastRequestError: Error {
+    /// There was no connected session to send the command on.
+    case notConnected
+}
+
+enum CastRequestOutcome {
+    case completed
+    case failed(Error)
+    case aborted(GCKRequestAbortReason)
+}
+
+/// Owns every `GCKRequest` the app sends, and the requests fan-out
+/// receivers send on media control channels of their own.
+///
+/// The tracker is the delegate of each request, so nothing completes
+/// silently. It records issue-to-completion latency per command, retries
+/// idempotent commands with exponential backoff and full jitter, and holds
+/// commands back once `maxInFlight` requests are outstanding. Main thread only.
+final class CastRequestTracker: NSObject, GCKRequestDelegate {
+
+    static let shared = CastRequestTracker()
+
+    typealias Send = () -> GCKRequest?
+    typealias Completion = (CastRequestOutcome) -> Void
+    /// Sends on a channel and returns the request ID, or `kGCKInvalidRequestID`.
+    typealias ChannelSend = (GCKMediaControlChannel) -> Int
+
+    private final class Operation {
+        let command: CastCommand
+        let send: Send
+        let completion: Completion?
+        let issued = CACurrentMediaTime()
+        var attempt = 0
+
+        init(command: CastCommand, send: @escaping Send, completion: Completion?) {
+            self.command = command
+            self.send = send
+            self.completion = completion
+        }
+    }
+
+    private final class ChannelOperation {
+        let command: CastCommand
+        weak var channel: GCKMediaControlChannel?
+        let send: ChannelSend
+        let retrying: Bool
+        let completion: Completion?
+        let issued = CACurrentMediaTime()
+        var attempt = 0
+
+        init(command: CastCommand, channel: GCKMediaControlChannel, retrying: Bool, send: @escaping ChannelSend, completion: Completion?) {
+            self.command = command
+            self.channel = channel
+            self.retrying = retrying
+            self.send = send
+            self.completion = completion
+        }
+    }
+
+    //MARK: Properties
+    var maxInFlight = 4
+    var maxRetries = 3
+    var baseBackoff: TimeInterval = 0.25
+
+    private var inFlight: [ObjectIdentifier: (request: GCKRequest, operation: Operation)] = [:]
+    private var waiting: [Operation] = []
+    /// By channel, then request ID.
+    private var channelInFlight: [ObjectIdentifier: [Int: ChannelOperation]] = [:]
+    private(set) var histograms: [CastCommand: LatencyHistogram] = [:]
+    private var failures: [CastCommand: Int] = [:]
+    private var retries: [CastCommand: Int] = [:]
+
+    /// Smoothed one-way delay to the receiver, half the round trip of
+    /// lightweight commands. Zero until one has completed.
+    private(set) var oneWayDelay: TimeInterval = 0
+
+    //MARK: Issuing
+
+    /// Sends `command` through `send` now, or as soon as a slot frees up.
+    /// `send` is called again for every retry and must build a fresh request.
+    func issue(_ command: CastCommand, send: @escaping Send, completion: Completion? = nil) {
+        let operation = Operation(command: command, send: send, completion: completion)
+        if inFlight.count >= maxInFlight {
+            waiting.append(operation)
+        } else {
+            start(operation)
+        }
+    }
+
+    private func start(_ operation: Operation) {
+        guard let request = operation.send() else {
+            finish(operation, outcome: .failed(CastRequestError.notConnected))
+            return
+        }
+        request.delegate = self
+        inFlight[ObjectIdentifier(request)] = (request, operation)
+    }
+
+    private func finish(_ operation: Operation, outcome: CastRequestOutcome) {
+        switch outcome {
+        case .completed:
+            let latency = CACurrentMediaTime() - operation.issued
+            record(operation.command, latency: latency)
+            if operation.command.isLightweight && operation.attempt == 0 {
+                oneWayDelay = oneWayDelay == 0 ? latency / 2 : oneWayDelay * 0.8 + latency / 2 * 0.2
+            }
+        case .failed:
+            failures[operation.command] = (failures[operation.command] ?? 0) + 1
+        case .aborted:
+            break
+        }
+        operation.completion?(outcome)
+    }
+
+    private func record(_ command: CastCommand, latency: TimeInterval) {
+        var histogram = histograms[command] ?? LatencyHistogram()
+        histogram.record(latency)
+        histograms[command] = histogram
+    }
+
+    /// Full jitter: anywhere between zero and the exponential ceiling.
+    private func backoff(forAttempt attempt: Int) -> TimeInterval {
+        let ceiling = baseBackoff * pow(2, Double(attempt - 1))
+        return ceiling * Double(arc4random_uniform(1001)) / 1000
+    }
+
+    private func drainWaiting() {
+        while inFlight.count < maxInFlight && !waiting.isEmpty {
+            start(waiting.removeFirst())
+        }
+    }
+
+    //MARK: GCKRequestDelegate
+    func requestDidComplete(_ request: GCKRequest) {
+        guard let entry = inFlight.removeValue(forKey: ObjectIdentifier(request)) else {
+            return
+        }
+        finish(entry.operation, outcome: .completed)
+        drainWaiting()
+    }
+
+    func request(_ request: GCKRequest, didFailWithError error: GCKError) {
+        guard let entry = inFlight.removeValue(forKey: ObjectIdentifier(request)) else {
+            return
+        }
+        let operation = entry.operation
+        if operation.command.isIdempotent && operation.attempt < maxRetries {
+            operation.attempt += 1
+            retries[operation.command] = (retries[operation.command] ?? 0) + 1
+            DispatchQueue.main.asyncAfter(deadline: .now() + backoff(forAttempt: operation.attempt)) {
+                self.issueRetry(operation)
+            }
+        } else {
+            finish(operation, outcome: .failed(error))
+        }
+        drainWaiting()
+    }
+
+    func request(_ request: GCKRequest, didAbortWith abortReason: GCKRequestAbortReason) {
+        guard let entry = inFlight.removeValue(forKey: ObjectIdentifier(request)) else {
+            return
+        }
+        finish(entry.operation, outcome: .aborted(abortReason))
+        drainWaiting()
+    }
+
+    /// Stops tracking every outstanding `command`, queued or in flight, and
+    /// completes each with `.aborted(.cancelled)`. The receiver may still act
+    /// on requests that were already sent.
+    func cancel(_ command: CastCommand) {
+        let cancelledWaiting = waiting.filter { $0.command == command }
+        waiting = waiting.filter { $0.command != command }
+        var cancelledInFlight: [(request: GCKRequest, operation: Operation)] = []
+        for (key, entry) in inFlight where entry.operation.command == command {
+            inFlight.removeValue(forKey: key)
+            cancelledInFlight.append(entry)
+        }
+        for entry in cancelledInFlight {
+            entry.request.cancel()
+            finish(entry.operation, outcome: .aborted(.cancelled))
+        }
+        for operation in cancelledWaiting {
+            finish(operation, outcome: .aborted(.cancelled))
+        }
+        drainWaiting()
+    }
+
+    private func issueRetry(_ operation: Operation) {
+        if inFlight.count >= maxInFlight {
+            waiting.insert(operation, at: 0)
+        } else {
+            start(operation)
+        }
+    }
+
+    //MARK: Channel requests
+
+    /// Sends `command` on `channel` now. Latency, failures and retries are
+    /// recorded as for session requests, but these do not count against
+    /// `maxInFlight`, since each fan-out receiver has its own connection, nor
+    /// toward `oneWayDelay`. Without `retrying`, a failure is final even for
+    /// an idempotent command, for commands only worth sending on time. The
+    /// channel's delegate must report back through the `channel(_:request...)`
+    /// methods.
+    func issue(_ command: CastCommand, on channel: GCKMediaControlChannel, retrying: Bool = true, send: @escaping ChannelSend, completion: Completion? = nil) {
+        start(ChannelOperation(command: command, channel: channel, retrying: retrying, send: send, completion: completion))
+    }
+
+    private func start(_ operation: ChannelOperation) {
+        guard let channel = operation.channel else {
+            finish(operation, outcome: .aborted(.cancelled))
+            return
+        }
+        let requestID = operation.send(channel)
+        guard requestID != kGCKInvalidRequestID else {
+            finish(operation, outcome: .failed(CastRequestError.notConnected))
+            return
+        }
+        var requests = channelInFlight[ObjectIdentifier(channel)] ?? [:]
+        requests[requestID] = operation
+        channelInFlight[ObjectIdentifier(channel)] = requests
+    }
+
+    private func finish(_ operation: ChannelOperation, outcome: CastRequestOutcome) {
+        switch outcome {
+        case .completed:
+            record(operation.command, latency: CACurrentMediaTime() - operation.issued)
+        case .failed:
+            failures[operation.command] = (failures[operation.command] ?? 0) + 1
+        case .aborted:
+            break
+        }
+        operation.completion?(outcome)
+    }
+
+    private func removeOperation(on channel: GCKMediaControlChannel, requestID: Int) -> ChannelOperation? {
+        let key = ObjectIdentifier(channel)
+        let operation = channelInFlight[key]?.removeValue(forKey: requestID)
+        if channelInFlight[key]?.isEmpty == true {
+            channelInFlight.removeValue(forKey: key)
+        }
+        return operation
+    }
+
+    func channel(_ channel: GCKMediaControlChannel, requestDidCompleteWithID requestID: Int) {
+        if let operation = removeOperation(on: channel, requestID: requestID) {
+            finish(operation, outcome: .completed)
+        }
+    }
+
+    func channel(_ channel: GCKMediaControlChannel, requestDidFailWithID requestID: Int, error: Error) {
+        guard let operation = removeOperation(on: channel, requestID: requestID) else {
+            return
+        }
+        if operation.retrying && operation.command.isIdempotent && operation.attempt < maxRetries {
+            operation.attempt += 1
+            retries[operation.command] = (retries[operation.command] ?? 0) + 1
+            DispatchQueue.main.asyncAfter(deadline: .now() + backoff(forAttempt: operation.attempt)) {
+                self.start(operation)
+            }
+        } else {
+            finish(operation, outcome: .failed(error))
+        }
+    }
+
+    /// For requests the channel cancelled or replaced with a newer one.
+    func channel(_ channel: GCKMediaControlChannel, requestDidAbortWithID requestID: Int, reason: GCKRequestAbortReason) {
+        if let operation = removeOperation(on: channel, requestID: requestID) {
+            finish(operation, outcome: .aborted(reason))
+        }
+    }
+
+    /// Completes everything outstanding on `channel` with `.aborted(.cancelled)`;
+    /// call when its connection is torn down.
+    func cancelRequests(on channel: GCKMediaControlChannel) {
+        let operations = channelInFlight.removeValue(forKey: ObjectIdentifier(channel)) ?? [:]
+        for (_, operation) in operations {
+            finish(operation, outcome: .aborted(.cancelled))
+        }
+    }
+
+    //MARK: Export
+
+    /// Per-command latency percentiles plus failure and retry counts.
+    func statistics() -> [String: Any] {
+        var commands: [String: Any] = [:]
+        let names = Set(histograms.keys).union(failures.keys).union(retries.keys)
+        for command in names {
+            var entry = (histograms[command] ?? LatencyHistogram()).summary()
+            entry["failures"] = failures[command] ?? 0
+            entry["retries"] = retries[command] ?? 0
+            commands[command.rawValue] = entry
+        }
+        return ["commands": commands, "in_flight": inFlight.count + channelInFlight.values.reduce(0) { $0 + $1.count }, "waiting": waiting.count, "one_way_delay_ms": oneWayDelay * 1000]
+    }
+
+    func exportJSON() -> Data? {
+        return try? JSONSerialization.data(withJSONObject: statistics(), options: [.prettyPrinted])
+    }
+
+    func reset() {
+        histograms = [:]
+        failures = [:]
+        retries = [:]
+    }
+}
@@ -0,0 +1,156 @@
+//
+//  DeviceCache.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+import GoogleCast
+
+/// Remembers the receivers seen before, so they can be offered the moment the
+/// app launches instead of after mDNS has answered.
+///
+/// Devices are archived with when and where they were last seen. At launch
+/// they come back as tentative; discovery confirms each one it finds, and any
+/// still unconfirmed after `confirmationWindow` are dropped from the list.
+/// A tentative device can be connected to straight away, as a session only
+/// needs its address. Main thread only.
+final class DeviceCache: NSObject, GCKSessionManagerListener {
+
+    static let shared = DeviceCache()
+    static let didChangeNotification = Notification.Name("DeviceCacheDidChange")
+
+    struct Entry {
+        let device: GCKDevice
+        var lastSeen: Date
+        /// `address:port` it was last reached at.
+        var address: String
+        /// Found by discovery in this run, rather than remembered.
+        var isConfirmed: Bool
+    }
+
+    //MARK: Properties
+    /// Devices not seen for this long are forgotten.
+    var maximumAge: TimeInterval = 14 * 24 * 60 * 60
+    /// How long discovery gets to confirm a remembered device.
+    var confirmationWindow: TimeInterval = 10
+
+    /// Confirmed devices first, then the rest by when they were last seen.
+    private(set) var entries: [Entry] = []
+    /// Remembered but no longer listed, kept so they are archived again.
+    private var evicted: [Entry] = []
+    private var startedAt: CFTimeInterval = 0
+    private(set) var timeToFirstDevice: TimeInterval?
+    private(set) var timeToFirstDiscoveredDevice: TimeInterval?
+
+    private var subscription: DiscoverySubscription?
+
+    private let fileURL = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask)[0].appendingPathComponent("Devices.archive")
+
+    //MARK: Lifecycle
+    func start() {
+        startedAt = CACurrentMediaTime()
+        entries = load()
+        if !entries.isEmpty {
+            timeToFirstDevice = 0
+        }
+        GCKCastContext.sharedInstance().sessionManager.add(self)
+        subscription = DiscoveryBatcher.shared.subscribe { [weak self] diff in
+            self?.apply(diff)
+        }
+        DispatchQueue.main.asyncAfter(deadline: .now() + confirmationWindow) { [weak self] in
+            self?.evictUnconfirmed()
+        }
+    }
+
+    /// A device from the list by its unique ID, tentative or not.
+    func device(withUniqueID uniqueID: String) -> GCKDevice? {
+        return entries.first { $0.device.uniqueID == uniqueID }?.device
+    }
+
+    func statistics() -> [String: Any] {
+        var statistics: [String: Any] = ["devices": entries.count, "confirmed": entries.filter { $0.isConfirmed }.count]
+        statistics["time_to_first_device"] = timeToFirstDevice
+        statistics["time_to_first_discovered_device"] = timeToFirstDiscoveredDevice
+        return statistics
+    }
+
+    //MARK: Updating
+    private func merge(_ device: GCKDevice, confirmed: Bool) {
+        let address = "\(device.ipAddress):\(device.servicePort)"
+        let entry = Entry(device: device, lastSeen: Date(), address: address, isConfirmed: confirmed)
+        evicted = evicted.filter { $0.device.uniqueID != device.uniqueID }
+        if let index = entries.index(where: { $0.device.uniqueID == device.uniqueID }) {
+            entries[index] = Entry(device: device, lastSeen: entry.lastSeen, address: address, isConfirmed: confirmed || entries[index].isConfirmed)
+        } else {
+            entries.append(entry)
+        }
+    }
+
+    private func evictUnconfirmed() {
+        let unconfirmed = entries.filter { !$0.isConfirmed }
+        guard !unconfirmed.isEmpty else {
+            return
+        }
+        evicted += unconfirmed
+        entries = entries.filter { $0.isConfirmed }
+        NotificationCenter.default.post(name: DeviceCache.didChangeNotification, object: self)
+    }
+
+    private func changed() {
+        entries.sort { ($0.isConfirmed ? 1 : 0, $0.lastSeen) > ($1.isConfirmed ? 1 : 0, $1.lastSeen) }
+        if timeToFirstDevice == nil && !entries.isEmpty {
+            timeToFirstDevice = CACurrentMediaTime() - startedAt
+        }
+        save()
+        NotificationCenter.default.post(name: DeviceCache.didChangeNotification, object: self)
+    }
+
+    //MARK: Persisting
+    private func load() -> [Entry] {
+        guard let archived = NSKeyedUnarchiver.unarchiveObject(withFile: fileURL.path) as? [[String: Any]] else {
+            return []
+        }
+        return archived.flatMap { fields -> Entry? in
+            guard let device = fields["device"] as? GCKDevice, let lastSeen = fields["lastSeen"] as? Date,
+                Date().timeIntervalSince(lastSeen) < maximumAge else {
+                return nil
+            }
+            return Entry(device: device, lastSeen: lastSeen, address: fields["address"] as? String ?? "", isConfirmed: false)
+        }
+    }
+
+    private func save() {
+        let archived: [[String: Any]] = (entries + evicted).map { ["device": $0.device, "lastSeen": $0.lastSeen, "address": $0.address] }
+        NSKeyedArchiver.archiveRootObject(archived, toFile: fileURL.path)
+    }
+
+    //MARK: Discovery
+    private func apply(_ diff: DeviceListDiff) {
+        guard !diff.isEmpty else {
+            return
+        }
+        if timeToFirstDiscoveredDevice == nil && !diff.devices.isEmpty {
+            timeToFirstDiscoveredDevice = CACurrentMediaTime() - startedAt
+        }
+        for device in diff.inserted + diff.updated {
+            merge(device, confirmed: true)
+        }
+        for device in diff.removed {
+            // Gone from the network for now; remembered for next time.
+            if let position = entries.index(where: { $0.device.uniqueID == device.uniqueID }) {
+                evicted.append(entries.remove(at: position))
+            }
+        }
+        changed()
+    }
+
+    //MARK: GCKSessionManagerListener
+    func sessionManager(_ sessionManager: GCKSessionManager, didStart session: GCKCastSession) {
+        merge(session.device, confirmed: true)
+        changed()
+    }
+}
@@ -0,0 +1,119 @@
+//
+//  DeviceListViewController.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import UIKit
+import GoogleCast
+
+/// The TVs from `DeviceCache`, available before discovery has finished.
+/// Remembered ones that discovery has not confirmed yet are shown dimmed.
+/// TVs that mDNS cannot see can be added by address. Each shows its round
+/// trip time from `DeviceProber`, and the quickest to start is marked.
+class DeviceListViewController: UITableViewController {
+
+    private var entries: [DeviceCache.Entry] = []
+    private var recommendedID: String?
+    private let dateFormatter: DateFormatter = {
+        let formatter = DateFormatter()
+        formatter.dateStyle = .short
+        formatter.timeStyle = .short
+        formatter.doesRelativeDateFormatting = true
+        return formatter
+    }()
+
+    override func viewDidLoad() {
+        super.viewDidLoad()
+        title = "TVs"
+        navigationItem.leftBarButtonItem = UIBarButtonItem(barButtonSystemItem: .done, target: self, action: #selector(donePressed))
+        navigationItem.rightBarButtonItem = UIBarButtonItem(barButtonSystemItem: .add, target: self, action: #selector(addPressed))
+        NotificationCenter.default.addObserver(self, selector: #selector(devicesDidChange), name: DeviceCache.didChangeNotification, object: nil)
+        NotificationCenter.default.addObserver(self, selector: #selector(devicesDidChange), name: DeviceProber.didChangeNotification, object: nil)
+        devicesDidChange()
+    }
+
+    override func viewWillAppear(_ animated: Bool) {
+        super.viewWillAppear(animated)
+        DiscoveryPolicy.shared.beginDemand()
+    }
+
+    override func viewDidDisappear(_ animated: Bool) {
+        super.viewDidDisappear(animated)
+        DiscoveryPolicy.shared.endDemand()
+    }
+
+    deinit {
+        NotificationCenter.default.removeObserver(self)
+    }
+
+    func devicesDidChange() {
+        entries = DeviceCache.shared.entries
+        recommendedID = DeviceProber.shared.recommendedDeviceID
+        tableView.reloadData()
+    }
+
+    func donePressed() {
+        dismiss(animated: true, completion: nil)
+    }
+
+    func addPressed() {
+        let alert = UIAlertController(title: "Add TV by address", message: "For networks where TVs do not show up on their own.", preferredStyle: .alert)
+        alert.addTextField { textField in
+            textField.placeholder = "192.168.1.20, tv.lan or tv.lan:8009"
+            textField.keyboardType = .URL
+            textField.autocapitalizationType = .none
+            textField.autocorrectionType = .no
+        }
+        alert.addAction(UIAlertAction(title: "Cancel", style: .cancel, handler: nil))
+        alert.addAction(UIAlertAction(title: "Add", style: .default) { _ in
+            guard let address = alert.textFields?.first?.text?.trimmingCharacters(in: .whitespaces), !address.isEmpty else {
+                return
+            }
+            let provider = ManualDeviceProvider.shared
+            if !provider.addresses.contains(address) {
+                provider.addresses.append(address)
+            }
+        })
+        present(alert, animated: true, completion: nil)
+    }
+
+    //MARK: Table view data source
+    override func tableView(_ tableView: UITableView, numberOfRowsInSection section: Int) -> Int {
+        return entries.count
+    }
+
+    override func tableView(_ tableView: UITableView, cellForRowAt indexPath: IndexPath) -> UITableViewCell {
+        let cell = tableView.dequeueReusableCell(withIdentifier: "device") ?? UITableViewCell(style: .subtitle, reuseIdentifier: "device")
+        let entry = entries[indexPath.row]
+        let connected = GCKCastContext.sharedInstance().sessionManager.currentCastSession?.device.uniqueID == entry.device.uniqueID
+        cell.textLabel?.text = entry.device.friendlyName ?? entry.address
+        cell.textLabel?.textColor = entry.isConfirmed ? .black : .gray
+        var details = [entry.isConfirmed ? entry.device.modelName ?? "" : "Last seen " + dateFormatter.string(from: entry.lastSeen)]
+        if let measurement = DeviceProber.shared.measurements[entry.device.uniqueID] {
+            details.append(String(format: "%.0f ms", measurement.roundTrip * 1000))
+        }
+        if entry.device.uniqueID == recommendedID {
+            details.insert("Recommended", at: 0)
+        }
+        cell.detailTextLabel?.text = details.filter { !$0.isEmpty }.joined(separator: " · ")
+        cell.accessoryType = connected ? .checkmark : .none
+        return cell
+    }
+
+    //MARK: Table view delegate
+    override func tableView(_ tableView: UITableView, didSelectRowAt indexPath: IndexPath) {
+        tableView.deselectRow(at: indexPath, animated: true)
+        let sessionManager = GCKCastContext.sharedInstance().sessionManager
+        let device = entries[indexPath.row].device
+        if sessionManager.currentCastSession?.device.uniqueID != device.uniqueID {
+            if sessionManager.hasConnectedSession() {
+                sessionManager.endSession()
+            }
+            sessionManager.startSession(with: device)
+        }
+        dismiss(animated: true, completion: nil)
+    }
+}
@@ -0,0 +1,233 @@
+//
+//  DeviceProber.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import UIKit
+import GoogleCast
+
+/// Measures how quickly each receiver answers, so the one likely to start
+/// playing soonest can be suggested.
+///
+/// Every `probeInterval` each discovered device gets a few TCP connects to
+/// its Cast port, which give its round trip time and, from how much
+/// consecutive samples differ, its jitter. Files the local server sends it,
+/// local media and prefetched segments, give the throughput from the phone
+/// to the receiver. Measurements are kept per Wi-Fi subnet, so they are back
+/// as soon as the phone rejoins a network. Main thread only, apart from the
+/// probes and `recordTransfer`.
+final class DeviceProber: NSObject {
+
+    static let shared = DeviceProber()
+    static let didChangeNotification = Notification.Name("DeviceProberDidChange")
+    private static let defaultsKey = "DeviceProberMeasurements"
+
+    struct Measurement {
+        /// Median connect time.
+        var roundTrip: TimeInterval
+        /// Mean difference between consecutive connect times.
+        var jitter: TimeInterval
+        /// Bytes per second the phone got through to the receiver, once it
+        /// has fetched a file from the local server.
+        var throughput: Double?
+        var measuredAt: Date
+    }
+
+    //MARK: Properties
+    var probeInterval: TimeInterval = 60
+    var samplesPerProbe = 5
+    var probeTimeout: TimeInterval = 1
+    /// Round trips before playback starts: TCP, TLS, virtual connection,
+    /// launch, media channel and load.
+    var roundTripsToStart = 6.0
+    /// What the receiver fetches before its first frame.
+    var bytesToStart = 2.0 * 1024 * 1024
+    /// Transfers smaller than this mostly fit the socket buffer and say
+    /// little about the link.
+    var minimumSampleBytes = 1 << 20
+
+    /// By device unique ID, for the current network.
+    private(set) var measurements: [String: Measurement] = [:]
+    private var network: String?
+    private var probing = Set<String>()
+    private var timer: Timer?
+    private let probeQueue = DispatchQueue(label: "DeviceProber", attributes: .concurrent)
+    private var subscription: DiscoverySubscription?
+
+    private var discoveryManager: GCKDiscoveryManager {
+        return GCKCastContext.sharedInstance().discoveryManager
+    }
+
+    //MARK: Lifecycle
+    func start() {
+        network = LocalMediaServer.wifiSubnet()
+        measurements = load()
+        timer = Timer.scheduledTimer(timeInterval: probeInterval, target: self, selector: #selector(probeAll), userInfo: nil, repeats: true)
+        subscription = DiscoveryBatcher.shared.subscribe { [weak self] _ in
+            self?.probeAll()
+        }
+    }
+
+    //MARK: Probing
+
+    /// Probes every discovered device without a recent measurement.
+    func probeAll() {
+        guard UIApplication.shared.applicationState != .background else {
+            return
+        }
+        let current = LocalMediaServer.wifiSubnet()
+        if current != network {
+            network = current
+            measurements = load()
+            probing.removeAll()
+            NotificationCenter.default.post(name: DeviceProber.didChangeNotification, object: self)
+        }
+        guard network != nil else {
+            return
+        }
+        for device in DiscoveryBatcher.shared.devices {
+            if let measured = measurements[device.uniqueID]?.measuredAt, Date().timeIntervalSince(measured) < probeInterval * 0.9 {
+                continue
+            }
+            probe(device)
+        }
+    }
+
+    private func probe(_ device: GCKDevice) {
+        let deviceID = device.uniqueID
+        guard !probing.contains(deviceID) else {
+            return
+        }
+        probing.insert(deviceID)
+        let host = device.ipAddress
+        let port = device.servicePort
+        let count = samplesPerProbe
+        let timeout = probeTimeout
+        let network = self.network
+        probeQueue.async {
+            let samples = (0..<count).flatMap { index -> TimeInterval? in
+                if index > 0 {
+                    usleep(100_000)
+                }
+                return TCPProbe.connect(host: host, port: port, timeout: timeout)
+            }
+            DispatchQueue.main.async {
+                self.probing.remove(deviceID)
+                if network == self.network {
+                    self.record(samples, for: deviceID)
+                }
+            }
+        }
+    }
+
+    private func record(_ samples: [TimeInterval], for deviceID: String) {
+        guard !samples.isEmpty else {
+            return
+        }
+        let sorted = samples.sorted()
+        var jitter: TimeInterval = 0
+        if samples.count > 1 {
+            jitter = zip(samples, samples.dropFirst()).reduce(0) { $0 + abs($1.1 - $1.0) } / Double(samples.count - 1)
+        }
+        let throughput = measurements[deviceID]?.throughput
+        measurements[deviceID] = Measurement(roundTrip: sorted[sorted.count / 2], jitter: jitter, throughput: throughput, measuredAt: Date())
+        changed()
+    }
+
+    /// Records a transfer the local server sent to `address`, credited to
+    /// the discovered device there. Callable from any thread.
+    func recordTransfer(bytes: Int, seconds: TimeInterval, to address: String) {
+        guard bytes >= minimumSampleBytes && seconds > 0 else {
+            return
+        }
+        let sample = Double(bytes) / seconds
+        DispatchQueue.main.async {
+            guard let deviceID = DiscoveryBatcher.shared.devices.first(where: { $0.ipAddress == address })?.uniqueID,
+                var measurement = self.measurements[deviceID] else {
+                return
+            }
+            measurement.throughput = measurement.throughput.map { $0 * 0.7 + sample * 0.3 } ?? sample
+            self.measurements[deviceID] = measurement
+            self.changed()
+        }
+    }
+
+    private func changed() {
+        save()
+        NotificationCenter.default.post(name: DeviceProber.didChangeNotification, object: self)
+    }
+
+    //MARK: Recommending
+
+    /// Seconds from picking the device to its first frame, going by the
+    /// measurements. A device that has not fetched a file yet is assumed to
+    /// manage the average throughput of those that have.
+    func expectedStartTime(forDeviceWithID deviceID: String) -> TimeInterval? {
+        guard let measurement = measurements[deviceID] else {
+            return nil
+        }
+        let known = measurements.values.flatMap { $0.throughput }
+        let throughput = measurement.throughput ?? (known.isEmpty ? nil : known.reduce(0, +) / Double(known.count))
+        let transfer = throughput.map { bytesToStart / $0 } ?? 0
+        return roundTripsToStart * measurement.roundTrip + 2 * measurement.jitter + transfer
+    }
+
+    /// The discovered device expected to start soonest, once there are at
+    /// least two to choose between.
+    var recommendedDeviceID: String? {
+        let candidates = DiscoveryBatcher.shared.devices.flatMap { device -> (String, TimeInterval)? in
+            let deviceID = device.uniqueID
+            return expectedStartTime(forDeviceWithID: deviceID).map { (deviceID, $0) }
+        }
+        guard candidates.count > 1 else {
+            return nil
+        }
+        return candidates.min { $0.1 < $1.1 }?.0
+    }
+
+    func statistics() -> [String: Any] {
+        var devices: [String: Any] = [:]
+        for (deviceID, measurement) in measurements {
+            var entry: [String: Any] = ["rtt_ms": measurement.roundTrip * 1000, "jitter_ms": measurement.jitter * 1000]
+            entry["throughput_kbps"] = measurement.throughput.map { $0 * 8 / 1000 }
+            entry["expected_start_ms"] = expectedStartTime(forDeviceWithID: deviceID).map { $0 * 1000 }
+            devices[discoveryManager.device(withUniqueID: deviceID)?.friendlyName ?? deviceID] = entry
+        }
+        var statistics: [String: Any] = ["network": network ?? "none", "devices": devices]
+        statistics["recommended"] = recommendedDeviceID.flatMap { discoveryManager.device(withUniqueID: $0)?.friendlyName }
+        return statistics
+    }
+
+    //MARK: Persisting
+    private func load() -> [String: Measurement] {
+        guard let network = network,
+            let saved = UserDefaults.standard.dictionary(forKey: DeviceProber.defaultsKey)?[network] as? [String: [String: Any]] else {
+            return [:]
+        }
+        var measurements: [String: Measurement] = [:]
+        for (deviceID, fields) in saved {
+            if let roundTrip = fields["rtt"] as? Double, let jitter = fields["jitter"] as? Double, let measuredAt = fields["at"] as? Date {
+                measurements[deviceID] = Measurement(roundTrip: roundTrip, jitter: jitter, throughput: fields["link_throughput"] as? Double, measuredAt: measuredAt)
+            }
+        }
+        return measurements
+    }
+
+    private func save() {
+        guard let network = network else {
+            return
+        }
+        var saved = UserDefaults.standard.dictionary(forKey: DeviceProber.defaultsKey) ?? [:]
+        var devices: [String: Any] = [:]
+        for (deviceID, measurement) in measurements {
+            var fields: [String: Any] = ["rtt": measurement.roundTrip, "jitter": measurement.jitter, "at": measurement.measuredAt]
+            fields["link_throughput"] = measurement.throughput
+            devices[deviceID] = fields
+        }
+        saved[network] = devices
+        UserDefaults.standard.set(saved, forKey: DeviceProber.defaultsKey)
+    }
+}
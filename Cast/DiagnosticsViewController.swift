@@ -0,0 +1,174 @@
+//
+//  DiagnosticsViewController.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import UIKit
+
+/// Every measurement the app keeps, in one place.
+///
+/// Each component's `statistics()` is a section, its nested fields flattened
+/// into dotted rows. The benchmarks are run from here and their results join
+/// the report, and the whole report can be shared as JSON.
+class DiagnosticsViewController: UITableViewController {
+
+    private enum Benchmark: String {
+        case readAhead = "read_ahead"
+        case localServer = "local_server_throughput"
+
+        static let all: [Benchmark] = [.readAhead, .localServer]
+
+        var title: String {
+            switch self {
+            case .readAhead:
+                return "Compare read-ahead"
+            case .localServer:
+                return "Local server throughput"
+            }
+        }
+    }
+
+    private var sections: [(title: String, rows: [(name: String, value: String)])] = []
+    private var results: [String: Any] = [:]
+    private var running = Set<String>()
+    private let standIn = OriginStandIn()
+
+    override func viewDidLoad() {
+        super.viewDidLoad()
+        title = "Diagnostics"
+        navigationItem.leftBarButtonItem = UIBarButtonItem(barButtonSystemItem: .done, target: self, action: #selector(donePressed))
+        navigationItem.rightBarButtonItem = UIBarButtonItem(barButtonSystemItem: .action, target: self, action: #selector(exportPressed))
+        refreshControl = UIRefreshControl()
+        refreshControl?.addTarget(self, action: #selector(reload), for: .valueChanged)
+        reload()
+    }
+
+    //MARK: Report
+
+    /// The statistics of every component and the benchmark results so far.
+    func report() -> [String: Any] {
+        var report: [String: Any] = [
+            "cast_requests": CastRequestTracker.shared.statistics(),
+            "discovery_batcher": DiscoveryBatcher.shared.statistics(),
+            "discovery_policy": DiscoveryPolicy.shared.statistics(),
+            "device_cache": DeviceCache.shared.statistics(),
+            "device_prober": DeviceProber.shared.statistics(),
+            "receiver_prewarmer": ReceiverPrewarmer.shared.statistics(),
+            "session_resumer": SessionResumer.shared.statistics(),
+            "seek_engine": SeekEngine.shared.statistics(),
+            "media_proxy": MediaProxy.shared.statistics(),
+            "segment_prefetcher": SegmentPrefetcher.shared.statistics(),
+            "fan_out": MultiDeviceCaster.shared.statistics(),
+            "web_content_blocker": WebContentBlocker.shared.statistics()
+        ]
+        if !results.isEmpty {
+            report["benchmarks"] = results
+        }
+        return report
+    }
+
+    func reload() {
+        let report = self.report()
+        sections = report.keys.sorted().map { key in
+            (title: key, rows: DiagnosticsViewController.rows(of: report[key]!, prefix: ""))
+        }
+        tableView.reloadData()
+        refreshControl?.endRefreshing()
+    }
+
+    private static func rows(of value: Any, prefix: String) -> [(name: String, value: String)] {
+        guard let dictionary = value as? [String: Any] else {
+            return [(prefix, format(value))]
+        }
+        return dictionary.keys.sorted().flatMap { key in
+            rows(of: dictionary[key]!, prefix: prefix.isEmpty ? key : prefix + "." + key)
+        }
+    }
+
+    private static func format(_ value: Any) -> String {
+        if let number = value as? Double, !(value is Int) {
+            return String(format: "%.2f", number)
+        }
+        return "\(value)"
+    }
+
+    //MARK: Actions
+    func donePressed() {
+        dismiss(animated: true, completion: nil)
+    }
+
+    func exportPressed(_ sender: UIBarButtonItem) {
+        guard let json = try? JSONSerialization.data(withJSONObject: report(), options: [.prettyPrinted]),
+            let text = String(data: json, encoding: .utf8) else {
+            return
+        }
+        let sheet = UIActivityViewController(activityItems: [text], applicationActivities: nil)
+        sheet.popoverPresentationController?.barButtonItem = sender
+        present(sheet, animated: true, completion: nil)
+    }
+
+    private func run(_ benchmark: Benchmark) {
+        guard !running.contains(benchmark.rawValue) else {
+            return
+        }
+        running.insert(benchmark.rawValue)
+        tableView.reloadSections(IndexSet(integer: 0), with: .none)
+        let completion: ([String: Any]) -> Void = { [weak self] result in
+            guard let strongSelf = self else {
+                return
+            }
+            strongSelf.running.remove(benchmark.rawValue)
+            strongSelf.results[benchmark.rawValue] = result
+            strongSelf.reload()
+        }
+        switch benchmark {
+        case .readAhead:
+            standIn.compareReadAhead(completion: completion)
+        case .localServer:
+            LocalMediaServer.shared.measureThroughput(completion: completion)
+        }
+    }
+
+    //MARK: Table view data source
+    override func numberOfSections(in tableView: UITableView) -> Int {
+        return sections.count + 1
+    }
+
+    override func tableView(_ tableView: UITableView, titleForHeaderInSection section: Int) -> String? {
+        return section == 0 ? "Run" : sections[section - 1].title
+    }
+
+    override func tableView(_ tableView: UITableView, numberOfRowsInSection section: Int) -> Int {
+        return section == 0 ? Benchmark.all.count : sections[section - 1].rows.count
+    }
+
+    override func tableView(_ tableView: UITableView, cellForRowAt indexPath: IndexPath) -> UITableViewCell {
+        let cell = tableView.dequeueReusableCell(withIdentifier: "measurement") ?? UITableViewCell(style: .value1, reuseIdentifier: "measurement")
+        if indexPath.section == 0 {
+            let benchmark = Benchmark.all[indexPath.row]
+            cell.textLabel?.text = benchmark.title
+            cell.textLabel?.textColor = view.tintColor
+            cell.detailTextLabel?.text = running.contains(benchmark.rawValue) ? "Running…" : nil
+            cell.selectionStyle = .default
+        } else {
+            let row = sections[indexPath.section - 1].rows[indexPath.row]
+            cell.textLabel?.text = row.name
+            cell.textLabel?.textColor = .black
+            cell.detailTextLabel?.text = row.value
+            cell.selectionStyle = .none
+        }
+        cell.textLabel?.adjustsFontSizeToFitWidth = true
+        return cell
+    }
+
+    //MARK: Table view delegate
+    override func tableView(_ tableView: UITableView, didSelectRowAt indexPath: IndexPath) {
+        tableView.deselectRow(at: indexPath, animated: true)
+        if indexPath.section == 0 {
+            run(Benchmark.all[indexPath.row])
+        }
+    }
+}
@@ -0,0 +1,173 @@
+//
+//  DiscoveryBatcher.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import GoogleCast
+
+/// What changed in the device list over one batch of discovery events.
+struct DeviceListDiff {
+    var inserted: [GCKDevice] = []
+    var updated: [GCKDevice] = []
+    var removed: [GCKDevice] = []
+    /// The whole list after the batch, in the SDK's order.
+    var devices: [GCKDevice] = []
+
+    var isEmpty: Bool {
+        return inserted.isEmpty && updated.isEmpty && removed.isEmpty
+    }
+}
+
+/// Keeps a subscription alive; dropping it unsubscribes.
+final class DiscoverySubscription {
+
+    fileprivate let id: Int
+    fileprivate weak var batcher: DiscoveryBatcher?
+
+    fileprivate init(id: Int, batcher: DiscoveryBatcher) {
+        self.id = id
+        self.batcher = batcher
+    }
+
+    func cancel() {
+        batcher?.unsubscribe(id)
+        batcher = nil
+    }
+
+    deinit {
+        cancel()
+    }
+}
+
+/// The one `GCKDiscoveryManagerListener` in the app.
+///
+/// The SDK reports every insert, update and removal on its own, which on a
+/// busy network means a stream of callbacks per scan. Here they only note
+/// which devices were touched; when the SDK's `didUpdateDeviceList` closes
+/// the batch, the list is diffed against the one published last and each
+/// subscriber gets a single diff. An insert and removal of the same device
+/// cancel out, repeated updates count once, and a batch that changed nothing
+/// is not published at all. Events outside a batch are flushed on the next
+/// turn of the run loop. Main thread only.
+final class DiscoveryBatcher: NSObject, GCKDiscoveryManagerListener {
+
+    static let shared = DiscoveryBatcher()
+
+    typealias Handler = (DeviceListDiff) -> Void
+
+    //MARK: Properties
+    /// The list as last published.
+    private(set) var devices: [GCKDevice] = []
+    private var subscribers: [Int: Handler] = [:]
+    private var nextSubscriberID = 0
+    private var updatedIDs = Set<String>()
+    private var batchDepth = 0
+    private var flushScheduled = false
+
+    private(set) var eventCount = 0
+    private(set) var publishedCount = 0
+    private(set) var emptyBatchCount = 0
+
+    private var discoveryManager: GCKDiscoveryManager {
+        return GCKCastContext.sharedInstance().discoveryManager
+    }
+
+    //MARK: Lifecycle
+
+    /// Starts following discovery. Call before anything subscribes.
+    func start() {
+        discoveryManager.add(self)
+        flush()
+    }
+
+    /// Calls `handler` once with the current list as insertions, then with
+    /// every diff after it.
+    func subscribe(_ handler: @escaping Handler) -> DiscoverySubscription {
+        let id = nextSubscriberID
+        nextSubscriberID += 1
+        subscribers[id] = handler
+        var initial = DeviceListDiff()
+        initial.inserted = devices
+        initial.devices = devices
+        handler(initial)
+        return DiscoverySubscription(id: id, batcher: self)
+    }
+
+    fileprivate func unsubscribe(_ id: Int) {
+        subscribers.removeValue(forKey: id)
+    }
+
+    func statistics() -> [String: Any] {
+        return ["events": eventCount, "published": publishedCount, "empty_batches": emptyBatchCount,
+                "events_per_publish": publishedCount == 0 ? 0 : Double(eventCount) / Double(publishedCount)]
+    }
+
+    //MARK: Batching
+    private func noteEvent() {
+        eventCount += 1
+        if batchDepth == 0 && !flushScheduled {
+            flushScheduled = true
+            DispatchQueue.main.async { [weak self] in
+                self?.flush()
+            }
+        }
+    }
+
+    private func flush() {
+        flushScheduled = false
+        let current = (0..<discoveryManager.deviceCount).map { discoveryManager.device(at: $0) }
+        let previousIDs = Set(devices.map { $0.uniqueID })
+        let currentIDs = Set(current.map { $0.uniqueID })
+
+        var diff = DeviceListDiff()
+        diff.devices = current
+        diff.inserted = current.filter { !previousIDs.contains($0.uniqueID) }
+        diff.updated = current.filter { previousIDs.contains($0.uniqueID) && updatedIDs.contains($0.uniqueID) }
+        diff.removed = devices.filter { !currentIDs.contains($0.uniqueID) }
+        devices = current
+        updatedIDs.removeAll()
+
+        guard !diff.isEmpty else {
+            emptyBatchCount += 1
+            return
+        }
+        publishedCount += 1
+        for (_, handler) in subscribers {
+            handler(diff)
+        }
+    }
+
+    //MARK: GCKDiscoveryManagerListener
+    func willUpdateDeviceList() {
+        batchDepth += 1
+    }
+
+    func didUpdateDeviceList() {
+        batchDepth = max(0, batchDepth - 1)
+        if batchDepth == 0 {
+            flush()
+        }
+    }
+
+    func didInsert(_ device: GCKDevice, at index: UInt) {
+        noteEvent()
+    }
+
+    func didUpdate(_ device: GCKDevice, at index: UInt) {
+        updatedIDs.insert(device.uniqueID)
+        noteEvent()
+    }
+
+    func didUpdate(_ device: GCKDevice, at index: UInt, andMoveTo newIndex: UInt) {
+        updatedIDs.insert(device.uniqueID)
+        noteEvent()
+    }
+
+    func didRemoveDevice(at index: UInt) {
+        noteEvent()
+    }
+}
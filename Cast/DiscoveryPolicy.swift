@@ -0,0 +1,203 @@
+//
+//  DiscoveryPolicy.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import UIKit
+import QuartzCore
+import GoogleCast
+
+/// Decides how hard discovery works, instead of leaving the SDK scanning
+/// actively the whole time the app is in the foreground.
+///
+/// Discovery scans actively while a device picker is on screen or the device
+/// list is still changing. Once the list has been quiet for `settleInterval`
+/// it drops to a passive scan, and with a session connected it stops
+/// altogether. In the background it is always stopped. The time spent in
+/// each mode is tallied, so the scanning saved against the SDK default can
+/// be read off `statistics()`. Main thread only.
+final class DiscoveryPolicy: NSObject, GCKSessionManagerListener {
+
+    static let shared = DiscoveryPolicy()
+
+    enum Mode: String {
+        case active
+        case passive
+        case stopped
+    }
+
+    //MARK: Properties
+    /// How long the device list has to stay unchanged before scanning eases off.
+    var settleInterval: TimeInterval = 20
+
+    private(set) var mode = Mode.stopped
+    private(set) var transitions = 0
+    private var isForeground = false
+    private var hasSession = false
+    /// Device pickers on screen; discovery stays active while there are any.
+    private var demand = 0
+    private var lastChange: CFTimeInterval = 0
+
+    private var modeStartedAt: CFTimeInterval = 0
+    private var tallyIsForeground = false
+    private var durations: [Mode: TimeInterval] = [:]
+    private var foregroundTime: TimeInterval = 0
+    private var timer: Timer?
+    private var subscription: DiscoverySubscription?
+
+    private var discoveryManager: GCKDiscoveryManager {
+        return GCKCastContext.sharedInstance().discoveryManager
+    }
+
+    //MARK: Lifecycle
+
+    /// Takes over discovery; the context must have been set up with
+    /// `disableDiscoveryAutostart`.
+    func start() {
+        let sessionManager = GCKCastContext.sharedInstance().sessionManager
+        sessionManager.add(self)
+        hasSession = sessionManager.hasConnectedSession()
+        isForeground = UIApplication.shared.applicationState != .background
+        lastChange = CACurrentMediaTime()
+        modeStartedAt = lastChange
+        tallyIsForeground = isForeground
+
+        let center = NotificationCenter.default
+        center.addObserver(self, selector: #selector(didBecomeActive), name: .UIApplicationDidBecomeActive, object: nil)
+        center.addObserver(self, selector: #selector(didEnterBackground), name: .UIApplicationDidEnterBackground, object: nil)
+        center.addObserver(self, selector: #selector(beginDemand), name: Notification.Name(kGCKUICastDialogWillShowNotification), object: nil)
+        center.addObserver(self, selector: #selector(endDemand), name: Notification.Name(kGCKUICastDialogDidHideNotification), object: nil)
+        subscription = DiscoveryBatcher.shared.subscribe { [weak self] _ in
+            self?.deviceListDidChange()
+        }
+    }
+
+    /// Call when a device picker of our own appears; balance with `endDemand()`.
+    func beginDemand() {
+        demand += 1
+        evaluate()
+    }
+
+    func endDemand() {
+        demand = max(0, demand - 1)
+        // Whatever turned up while the picker was open gets a full settle period.
+        lastChange = CACurrentMediaTime()
+        evaluate()
+    }
+
+    func didBecomeActive() {
+        isForeground = true
+        lastChange = CACurrentMediaTime()
+        evaluate()
+    }
+
+    func didEnterBackground() {
+        isForeground = false
+        evaluate()
+    }
+
+    //MARK: Deciding
+    private func evaluate() {
+        timer?.invalidate()
+        timer = nil
+        let settledIn = lastChange + settleInterval - CACurrentMediaTime()
+
+        let next: Mode
+        if !isForeground {
+            next = .stopped
+        } else if demand > 0 {
+            next = .active
+        } else if settledIn > 0 {
+            next = hasSession ? .passive : .active
+        } else {
+            next = hasSession ? .stopped : .passive
+        }
+        if next != .stopped && settledIn > 0 && demand == 0 {
+            timer = Timer.scheduledTimer(timeInterval: settledIn, target: self, selector: #selector(settle), userInfo: nil, repeats: false)
+        }
+        apply(next)
+    }
+
+    func settle() {
+        evaluate()
+    }
+
+    private func apply(_ next: Mode) {
+        account()
+        guard next != mode || discoveryManager.discoveryActive != (next != .stopped) else {
+            return
+        }
+        if next != mode {
+            transitions += 1
+        }
+        mode = next
+        switch next {
+        case .active, .passive:
+            discoveryManager.passiveScan = next == .passive
+            if !discoveryManager.discoveryActive {
+                discoveryManager.startDiscovery()
+            }
+        case .stopped:
+            if discoveryManager.discoveryActive {
+                discoveryManager.stopDiscovery()
+            }
+        }
+    }
+
+    //MARK: Measuring
+
+    /// Closes the running tally for the current mode. Only foreground time
+    /// counts, since the SDK stops by itself in the background.
+    private func account() {
+        let now = CACurrentMediaTime()
+        if tallyIsForeground {
+            durations[mode] = (durations[mode] ?? 0) + now - modeStartedAt
+            foregroundTime += now - modeStartedAt
+        }
+        modeStartedAt = now
+        tallyIsForeground = isForeground
+    }
+
+    /// Seconds spent in each mode in the foreground, and the scanning saved
+    /// per foreground hour against scanning actively throughout: active
+    /// scanning avoided, and scanning of any kind avoided.
+    func statistics() -> [String: Any] {
+        account()
+        let active = durations[.active] ?? 0
+        let stopped = durations[.stopped] ?? 0
+        let hours = foregroundTime / 3600
+        var statistics: [String: Any] = ["mode": mode.rawValue, "transitions": transitions, "foreground_seconds": foregroundTime,
+                                         "active_seconds": active, "passive_seconds": durations[.passive] ?? 0, "stopped_seconds": stopped]
+        if hours > 0 {
+            statistics["active_scan_saved_seconds_per_hour"] = (foregroundTime - active) / hours
+            statistics["scan_saved_seconds_per_hour"] = stopped / hours
+        }
+        return statistics
+    }
+
+    //MARK: Discovery
+    private func deviceListDidChange() {
+        lastChange = CACurrentMediaTime()
+        evaluate()
+    }
+
+    //MARK: GCKSessionManagerListener
+    func sessionManager(_ sessionManager: GCKSessionManager, didStart session: GCKSession) {
+        hasSession = true
+        evaluate()
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didResumeSession session: GCKSession) {
+        hasSession = true
+        evaluate()
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didEnd session: GCKSession, withError error: Error?) {
+        hasSession = false
+        lastChange = CACurrentMediaTime()
+        evaluate()
+    }
+}
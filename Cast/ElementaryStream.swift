@@ -0,0 +1,330 @@
+//
+//  ElementaryStream.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// What a container demuxer hands to a muxer: codec configurations and
+/// compressed frames, untouched apart from their framing.
+
+struct VideoConfig {
+    /// AVCDecoderConfigurationRecord, as it goes into `avcC`.
+    let avcC: [UInt8]
+    let width: Int
+    let height: Int
+}
+
+struct AudioConfig {
+    /// AudioSpecificConfig, as it goes into `esds`.
+    let audioSpecificConfig: [UInt8]
+    let sampleRate: Int
+    let channels: Int
+}
+
+struct MediaSample {
+    let isVideo: Bool
+    /// Length-prefixed NAL units for video, one raw AAC frame for audio.
+    let data: [UInt8]
+    /// In 90 kHz ticks.
+    let decodeTime: Int64
+    let compositionOffset: Int64
+    let isKeyframe: Bool
+}
+
+enum DemuxEvent {
+    /// The tracks the container declares, once it has said.
+    case tracks(video: Bool, audio: Bool)
+    case videoConfig(VideoConfig)
+    case audioConfig(AudioConfig)
+    case sample(MediaSample)
+    /// A codec that cannot be carried over without re-encoding.
+    case unsupported(String)
+}
+
+protocol MediaDemuxer: class {
+    /// Parses whatever `data`, after earlier leftovers, completes.
+    func append(_ data: Data) -> [DemuxEvent]
+    /// Whatever is left once the input has ended.
+    func finish() -> [DemuxEvent]
+}
+
+enum Bytes {
+
+    static func uint16(_ bytes: [UInt8], _ at: Int) -> Int {
+        return Int(bytes[at]) << 8 | Int(bytes[at + 1])
+    }
+
+    static func uint24(_ bytes: [UInt8], _ at: Int) -> Int {
+        return Int(bytes[at]) << 16 | Int(bytes[at + 1]) << 8 | Int(bytes[at + 2])
+    }
+
+    static func uint32(_ bytes: [UInt8], _ at: Int) -> Int {
+        return Int(bytes[at]) << 24 | Int(bytes[at + 1]) << 16 | Int(bytes[at + 2]) << 8 | Int(bytes[at + 3])
+    }
+
+    static func littleUInt16(_ bytes: [UInt8], _ at: Int) -> Int {
+        return Int(bytes[at]) | Int(bytes[at + 1]) << 8
+    }
+
+    static func littleUInt32(_ bytes: [UInt8], _ at: Int) -> Int {
+        return Int(bytes[at]) | Int(bytes[at + 1]) << 8 | Int(bytes[at + 2]) << 16 | Int(bytes[at + 3]) << 24
+    }
+
+    static func fourCC(_ bytes: [UInt8], _ at: Int) -> String {
+        return String(bytes: bytes[at..<(at + 4)], encoding: .isoLatin1) ?? ""
+    }
+}
+
+/// H.264 framing: Annex B start codes on one side, length prefixes and an
+/// `avcC` record on the other.
+enum H264 {
+
+    /// The NAL units between the start codes of an Annex B stream.
+    static func nalUnits(inAnnexB bytes: [UInt8]) -> [ArraySlice<UInt8>] {
+        var units: [ArraySlice<UInt8>] = []
+        var start: Int?
+        var index = 0
+        while index + 2 < bytes.count {
+            if bytes[index] == 0 && bytes[index + 1] == 0 && bytes[index + 2] == 1 {
+                if let unitStart = start {
+                    // A four-byte start code leaves one zero behind.
+                    let end = index > unitStart && bytes[index - 1] == 0 ? index - 1 : index
+                    units.append(bytes[unitStart..<end])
+                }
+                index += 3
+                start = index
+            } else {
+                index += 1
+            }
+        }
+        if let unitStart = start, unitStart < bytes.count {
+            units.append(bytes[unitStart..<bytes.count])
+        }
+        return units.filter { !$0.isEmpty }
+    }
+
+    static func type(of unit: ArraySlice<UInt8>) -> UInt8 {
+        return unit[unit.startIndex] & 0x1f
+    }
+
+    /// Four-byte length prefixes instead of start codes.
+    static func lengthPrefixed(_ units: [ArraySlice<UInt8>]) -> [UInt8] {
+        var bytes: [UInt8] = []
+        for unit in units {
+            let count = unit.count
+            bytes += [UInt8(truncatingBitPattern: count >> 24), UInt8(truncatingBitPattern: count >> 16), UInt8(truncatingBitPattern: count >> 8), UInt8(truncatingBitPattern: count)]
+            bytes += unit
+        }
+        return bytes
+    }
+
+    /// Whether length-prefixed `bytes` hold an IDR slice.
+    static func containsIDR(lengthPrefixed bytes: [UInt8], lengthSize: Int = 4) -> Bool {
+        var index = 0
+        while index + lengthSize < bytes.count {
+            var length = 0
+            for offset in 0..<lengthSize {
+                length = length << 8 | Int(bytes[index + offset])
+            }
+            if bytes[index + lengthSize] & 0x1f == 5 {
+                return true
+            }
+            index += lengthSize + length
+        }
+        return false
+    }
+
+    /// An `avcC` record with four-byte lengths for one SPS and one PPS, or
+    /// nil if they are too short to carry a profile or too long for the record.
+    static func decoderConfiguration(sps: [UInt8], pps: [UInt8]) -> [UInt8]? {
+        guard sps.count >= 4, !pps.isEmpty, sps.count < 0x10000, pps.count < 0x10000 else {
+            return nil
+        }
+        var record: [UInt8] = [1, sps[1], sps[2], sps[3], 0xff, 0xe1]
+        record += [UInt8(sps.count >> 8), UInt8(sps.count & 0xff)] + sps
+        record += [1, UInt8(pps.count >> 8), UInt8(pps.count & 0xff)] + pps
+        return record
+    }
+
+    /// The first SPS inside an `avcC` record.
+    static func sequenceParameterSet(inDecoderConfiguration record: [UInt8]) -> [UInt8]? {
+        guard record.count > 8, record[5] & 0x1f > 0 else {
+            return nil
+        }
+        let length = Bytes.uint16(record, 6)
+        return record.count >= 8 + length ? Array(record[8..<(8 + length)]) : nil
+    }
+
+    /// Picture size from a sequence parameter set, or nil if it cannot be read.
+    static func dimensions(ofSequenceParameterSet sps: [UInt8]) -> (width: Int, height: Int)? {
+        // Drop emulation prevention bytes first.
+        var rbsp: [UInt8] = []
+        var zeros = 0
+        for byte in sps.dropFirst() {
+            if zeros >= 2 && byte == 3 {
+                zeros = 0
+                continue
+            }
+            zeros = byte == 0 ? zeros + 1 : 0
+            rbsp.append(byte)
+        }
+        var reader = BitReader(rbsp)
+        guard let profile = reader.bits(8) else {
+            return nil
+        }
+        _ = reader.bits(16)
+        _ = reader.exponentialGolomb()
+        var chromaFormat = 1
+        if [100, 110, 122, 244, 44, 83, 86, 118, 128, 138, 139, 134, 135].contains(profile) {
+            chromaFormat = reader.exponentialGolomb() ?? 1
+            if chromaFormat == 3 {
+                _ = reader.bits(1)
+            }
+            _ = reader.exponentialGolomb()
+            _ = reader.exponentialGolomb()
+            _ = reader.bits(1)
+            if reader.bits(1) == 1 {
+                for list in 0..<(chromaFormat == 3 ? 12 : 8) where reader.bits(1) == 1 {
+                    var last = 8
+                    var next = 8
+                    for _ in 0..<(list < 6 ? 16 : 64) where next != 0 {
+                        next = (last + (reader.signedExponentialGolomb() ?? 0) + 256) % 256
+                        last = next == 0 ? last : next
+                    }
+                }
+            }
+        }
+        _ = reader.exponentialGolomb()
+        let pocType = reader.exponentialGolomb() ?? 0
+        if pocType == 0 {
+            _ = reader.exponentialGolomb()
+        } else if pocType == 1 {
+            _ = reader.bits(1)
+            _ = reader.signedExponentialGolomb()
+            _ = reader.signedExponentialGolomb()
+            for _ in 0..<(reader.exponentialGolomb() ?? 0) {
+                _ = reader.signedExponentialGolomb()
+            }
+        }
+        _ = reader.exponentialGolomb()
+        _ = reader.bits(1)
+        guard let widthInMacroblocks = reader.exponentialGolomb(), let heightInMapUnits = reader.exponentialGolomb(),
+            let frameMacroblocksOnly = reader.bits(1) else {
+            return nil
+        }
+        if frameMacroblocksOnly == 0 {
+            _ = reader.bits(1)
+        }
+        _ = reader.bits(1)
+        var crop = (left: 0, right: 0, top: 0, bottom: 0)
+        if reader.bits(1) == 1 {
+            crop = (reader.exponentialGolomb() ?? 0, reader.exponentialGolomb() ?? 0, reader.exponentialGolomb() ?? 0, reader.exponentialGolomb() ?? 0)
+        }
+        let cropX = chromaFormat == 1 || chromaFormat == 2 ? 2 : 1
+        let cropY = (chromaFormat == 1 ? 2 : 1) * (2 - frameMacroblocksOnly)
+        let width = (widthInMacroblocks + 1) * 16 - (crop.left + crop.right) * cropX
+        let height = (2 - frameMacroblocksOnly) * (heightInMapUnits + 1) * 16 - (crop.top + crop.bottom) * cropY
+        return width > 0 && height > 0 ? (width, height) : nil
+    }
+}
+
+/// AAC framing: ADTS headers on one side, raw frames and an
+/// AudioSpecificConfig on the other.
+enum AAC {
+
+    static let sampleRates = [96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350]
+
+    /// Splits an ADTS stream into raw frames, with the configuration of the
+    /// first. Stops at anything that is not a complete ADTS frame.
+    static func frames(inADTS bytes: [UInt8]) -> (config: AudioConfig?, frames: [[UInt8]]) {
+        var config: AudioConfig?
+        var frames: [[UInt8]] = []
+        var index = 0
+        while index + 7 <= bytes.count && bytes[index] == 0xff && bytes[index + 1] & 0xf0 == 0xf0 {
+            let headerLength = bytes[index + 1] & 0x01 == 1 ? 7 : 9
+            let frameLength = Int(bytes[index + 3] & 0x03) << 11 | Int(bytes[index + 4]) << 3 | Int(bytes[index + 5]) >> 5
+            guard frameLength > headerLength, index + frameLength <= bytes.count else {
+                break
+            }
+            if config == nil {
+                let objectType = Int(bytes[index + 2] >> 6) + 1
+                let frequencyIndex = Int(bytes[index + 2] >> 2) & 0x0f
+                let channels = Int(bytes[index + 2] & 0x01) << 2 | Int(bytes[index + 3] >> 6)
+                let specific = objectType << 11 | frequencyIndex << 7 | channels << 3
+                config = AudioConfig(audioSpecificConfig: [UInt8(specific >> 8), UInt8(specific & 0xff)],
+                                     sampleRate: frequencyIndex < sampleRates.count ? sampleRates[frequencyIndex] : 44100,
+                                     channels: channels)
+            }
+            frames.append(Array(bytes[(index + headerLength)..<(index + frameLength)]))
+            index += frameLength
+        }
+        return (config, frames)
+    }
+
+    /// Reads rate and channels out of an AudioSpecificConfig.
+    static func configuration(_ specific: [UInt8]) -> AudioConfig? {
+        var reader = BitReader(specific)
+        guard let objectType = reader.bits(5), objectType > 0, let frequencyIndex = reader.bits(4) else {
+            return nil
+        }
+        let sampleRate = frequencyIndex == 15 ? reader.bits(24) ?? 0 : frequencyIndex < sampleRates.count ? sampleRates[frequencyIndex] : 0
+        guard let channels = reader.bits(4), sampleRate > 0 else {
+            return nil
+        }
+        return AudioConfig(audioSpecificConfig: specific, sampleRate: sampleRate, channels: channels)
+    }
+}
+
+/// Reads big-endian bit fields and Exp-Golomb codes. Reads past the end return nil.
+struct BitReader {
+
+    private let bytes: [UInt8]
+    private var position = 0
+
+    init(_ bytes: [UInt8]) {
+        self.bytes = bytes
+    }
+
+    mutating func bits(_ count: Int) -> Int? {
+        if position + count > bytes.count * 8 {
+            return nil
+        }
+        var value = 0
+        for _ in 0..<count {
+            value = value << 1 | Int(bytes[position >> 3] >> UInt8(7 - position & 7)) & 1
+            position += 1
+        }
+        return value
+    }
+
+    mutating func exponentialGolomb() -> Int? {
+        var zeros = 0
+        while true {
+            guard let bit = bits(1) else {
+                return nil
+            }
+            if bit == 1 {
+                break
+            }
+            zeros += 1
+            if zeros > 31 {
+                return nil
+            }
+        }
+        guard let suffix = bits(zeros) else {
+            return nil
+        }
+        return (1 << zeros) - 1 + suffix
+    }
+
+    mutating func signedExponentialGolomb() -> Int? {
+        guard let code = exponentialGolomb() else {
+            return nil
+        }
+        return code & 1 == 1 ? (code + 1) / 2 : -(code / 2)
+    }
+}
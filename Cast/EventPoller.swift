@@ -0,0 +1,80 @@
+//
+//  EventPoller.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Darwin
+import Foundation
+
+struct PollEvent {
+    let fd: Int32
+    let readable: Bool
+    let writable: Bool
+    /// The peer hung up or the descriptor is in error.
+    let closed: Bool
+}
+
+/// Readiness notification for non-blocking descriptors. Implementations are
+/// used from a single event loop thread.
+protocol EventPoller: class {
+    /// Sets the events `fd` is watched for, adding it if it is new.
+    func watch(_ fd: Int32, read: Bool, write: Bool)
+    /// Stops watching `fd`. Call before closing it.
+    func unwatch(_ fd: Int32)
+    /// Blocks until something is ready or `timeout` passes.
+    func wait(timeout: TimeInterval) -> [PollEvent]
+}
+
+/// The poller the server runs on: kqueue, the only one shipped.
+func makeEventPoller() -> EventPoller {
+    return KqueuePoller()
+}
+
+final class KqueuePoller: EventPoller {
+
+    private let queueFD = kqueue()
+    private var events = [kevent](repeating: kevent(), count: 64)
+
+    deinit {
+        Darwin.close(queueFD)
+    }
+
+    func watch(_ fd: Int32, read: Bool, write: Bool) {
+        var changes = [
+            kevent(ident: UInt(fd), filter: Int16(EVFILT_READ), flags: UInt16(EV_ADD | (read ? EV_ENABLE : EV_DISABLE)), fflags: 0, data: 0, udata: nil),
+            kevent(ident: UInt(fd), filter: Int16(EVFILT_WRITE), flags: UInt16(EV_ADD | (write ? EV_ENABLE : EV_DISABLE)), fflags: 0, data: 0, udata: nil)
+        ]
+        kevent(queueFD, &changes, Int32(changes.count), nil, 0, nil)
+    }
+
+    func unwatch(_ fd: Int32) {
+        var changes = [
+            kevent(ident: UInt(fd), filter: Int16(EVFILT_READ), flags: UInt16(EV_DELETE), fflags: 0, data: 0, udata: nil),
+            kevent(ident: UInt(fd), filter: Int16(EVFILT_WRITE), flags: UInt16(EV_DELETE), fflags: 0, data: 0, udata: nil)
+        ]
+        kevent(queueFD, &changes, Int32(changes.count), nil, 0, nil)
+    }
+
+    func wait(timeout: TimeInterval) -> [PollEvent] {
+        var deadline = timespec(tv_sec: Int(timeout), tv_nsec: Int((timeout - floor(timeout)) * 1_000_000_000))
+        let count = kevent(queueFD, nil, 0, &events, Int32(events.count), &deadline)
+        if count <= 0 {
+            return []
+        }
+        // Read and write readiness arrive as separate events; merge them per descriptor.
+        var merged: [Int32: PollEvent] = [:]
+        for event in events[0..<Int(count)] {
+            let fd = Int32(event.ident)
+            let previous = merged[fd]
+            let closed = event.flags & UInt16(EV_ERROR) != 0 || (event.flags & UInt16(EV_EOF) != 0 && event.filter == Int16(EVFILT_WRITE))
+            merged[fd] = PollEvent(fd: fd,
+                                   readable: (previous?.readable ?? false) || event.filter == Int16(EVFILT_READ),
+                                   writable: (previous?.writable ?? false) || event.filter == Int16(EVFILT_WRITE),
+                                   closed: (previous?.closed ?? false) || closed)
+        }
+        return Array(merged.values)
+    }
+}
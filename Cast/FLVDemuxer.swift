@@ -0,0 +1,119 @@
+//
+//  FLVDemuxer.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// Splits an FLV stream into H.264 and AAC frames.
+///
+/// FLV already carries both in the form MP4 wants: the video sequence
+/// header is an `avcC` record and frames are length-prefixed, and the audio
+/// sequence header is an AudioSpecificConfig. Only one tag is held at a time.
+final class FLVDemuxer: MediaDemuxer {
+
+    //MARK: Properties
+    private var buffer: [UInt8] = []
+    private var headerRead = false
+    private var lengthSize = 4
+
+    //MARK: MediaDemuxer
+    func append(_ data: Data) -> [DemuxEvent] {
+        buffer.append(contentsOf: data)
+        var events: [DemuxEvent] = []
+        var offset = 0
+
+        if !headerRead {
+            // "FLV", version, flags, header size, then the first previous-tag size.
+            guard buffer.count >= 9 else {
+                return events
+            }
+            guard buffer[0] == 0x46 && buffer[1] == 0x4c && buffer[2] == 0x56 else {
+                return [.unsupported("not FLV")]
+            }
+            let headerSize = Bytes.uint32(buffer, 5)
+            guard buffer.count >= headerSize + 4 else {
+                return events
+            }
+            events.append(.tracks(video: buffer[4] & 0x01 != 0, audio: buffer[4] & 0x04 != 0))
+            headerRead = true
+            offset = headerSize + 4
+        }
+
+        // Tag: type, data size, timestamp (24 bits plus an extension byte), stream id, data, previous-tag size.
+        while offset + 11 <= buffer.count {
+            let type = buffer[offset]
+            let size = Bytes.uint24(buffer, offset + 1)
+            guard offset + 11 + size + 4 <= buffer.count else {
+                break
+            }
+            let timestamp = Int64(Int(buffer[offset + 7]) << 24 | Bytes.uint24(buffer, offset + 4))
+            let body = offset + 11
+            if size > 0 {
+                switch type {
+                case 9:
+                    events += video(at: body, size: size, timestamp: timestamp)
+                case 8:
+                    events += audio(at: body, size: size, timestamp: timestamp)
+                default:
+                    break
+                }
+            }
+            offset = body + size + 4
+        }
+        buffer.removeFirst(offset)
+        return events
+    }
+
+    func finish() -> [DemuxEvent] {
+        return []
+    }
+
+    //MARK: Tags
+    private func video(at body: Int, size: Int, timestamp: Int64) -> [DemuxEvent] {
+        let frameType = buffer[body] >> 4
+        guard buffer[body] & 0x0f == 7 else {
+            return [.unsupported("FLV video codec \(buffer[body] & 0x0f)")]
+        }
+        guard size > 5 else {
+            return []
+        }
+        let payload = Array(buffer[(body + 5)..<(body + size)])
+        switch buffer[body + 1] {
+        case 0:
+            guard payload.count > 4, let sps = H264.sequenceParameterSet(inDecoderConfiguration: payload) else {
+                return []
+            }
+            lengthSize = Int(payload[4] & 0x03) + 1
+            let size = H264.dimensions(ofSequenceParameterSet: sps)
+            return [.videoConfig(VideoConfig(avcC: payload, width: size?.width ?? 0, height: size?.height ?? 0))]
+        case 1:
+            // Composition time is a signed 24-bit count of milliseconds.
+            var composition = Bytes.uint24(buffer, body + 2)
+            if composition & 0x800000 != 0 {
+                composition -= 0x1000000
+            }
+            let keyframe = frameType == 1 || H264.containsIDR(lengthPrefixed: payload, lengthSize: lengthSize)
+            return [.sample(MediaSample(isVideo: true, data: payload, decodeTime: timestamp * 90, compositionOffset: Int64(max(composition, 0) * 90), isKeyframe: keyframe))]
+        default:
+            return []
+        }
+    }
+
+    private func audio(at body: Int, size: Int, timestamp: Int64) -> [DemuxEvent] {
+        guard buffer[body] >> 4 == 10 else {
+            return [.unsupported("FLV audio format \(buffer[body] >> 4)")]
+        }
+        guard size > 2 else {
+            return []
+        }
+        let payload = Array(buffer[(body + 2)..<(body + size)])
+        if buffer[body + 1] == 0 {
+            return AAC.configuration(payload).map { [.audioConfig($0)] } ?? []
+        }
+        return [.sample(MediaSample(isVideo: false, data: payload, decodeTime: timestamp * 90, compositionOffset: 0, isKeyframe: true))]
+    }
+}
@@ -0,0 +1,286 @@
+//
+//  FragmentedMP4Writer.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// Packs demuxed H.264 and AAC frames into fragmented MP4.
+///
+/// The init segment goes out as soon as every declared track has its
+/// configuration, then a `moof`/`mdat` pair every `fragmentDuration` of
+/// video. Output starts at the first keyframe, and every sample is held
+/// only until the one after it gives its duration, so the first bytes leave
+/// well under a second into the source.
+final class FragmentedMP4Writer {
+
+    private final class Track {
+        let id: UInt32
+        let timescale: Int64
+        var samples: [MediaSample] = []
+        /// The sample waiting for its successor to learn its duration.
+        var held: MediaSample?
+        var lastDuration: Int64 = 0
+
+        init(id: UInt32, timescale: Int64) {
+            self.id = id
+            self.timescale = timescale
+        }
+
+        /// 90 kHz ticks in this track's timescale.
+        func scaled(_ ticks: Int64) -> Int64 {
+            return ticks * timescale / 90000
+        }
+    }
+
+    //MARK: Properties
+    var fragmentDuration: TimeInterval = 0.5
+    /// Frames queued while waiting for configurations; past this the source is given up on.
+    var maximumQueuedSamples = 600
+    private(set) var failure: String?
+    private(set) var fragmentsWritten: UInt32 = 0
+
+    private var expectsVideo: Bool?
+    private var expectsAudio: Bool?
+    private var videoConfig: VideoConfig?
+    private var audioConfig: AudioConfig?
+    private var video: Track?
+    private var audio: Track?
+    private var queued: [MediaSample] = []
+    /// Decode time all tracks start from, in 90 kHz ticks.
+    private var origin: Int64?
+
+    //MARK: Methods
+
+    /// Takes demuxer output and returns the MP4 bytes it completes.
+    func write(_ events: [DemuxEvent]) -> [UInt8] {
+        var output: [UInt8] = []
+        for event in events where failure == nil {
+            switch event {
+            case .tracks(let hasVideo, let hasAudio):
+                expectsVideo = hasVideo
+                expectsAudio = hasAudio
+            case .videoConfig(let config):
+                videoConfig = videoConfig ?? config
+            case .audioConfig(let config):
+                audioConfig = audioConfig ?? config
+            case .unsupported(let reason):
+                failure = reason
+                return output
+            case .sample(let sample):
+                if video == nil && audio == nil {
+                    queued.append(sample)
+                    if queued.count > maximumQueuedSamples {
+                        failure = "no codec configuration"
+                    } else if queued.count > maximumQueuedSamples / 4 && (videoConfig != nil || audioConfig != nil) {
+                        // A declared track that never shows up is left out rather than holding up the other.
+                        expectsVideo = videoConfig != nil
+                        expectsAudio = audioConfig != nil
+                    }
+                } else {
+                    output += add(sample)
+                }
+            }
+            if video == nil && audio == nil, let initialization = initializationSegment() {
+                output += initialization
+                let pending = queued
+                queued = []
+                for sample in pending {
+                    output += add(sample)
+                }
+            }
+        }
+        return output
+    }
+
+    /// Flushes everything held once the input has ended.
+    func finish() -> [UInt8] {
+        for track in [video, audio].flatMap({ $0 }) {
+            if let held = track.held {
+                track.samples.append(held)
+                track.held = nil
+            }
+        }
+        return fragment()
+    }
+
+    //MARK: Samples
+    private func add(_ sample: MediaSample) -> [UInt8] {
+        guard let track = sample.isVideo ? video : audio else {
+            return []
+        }
+        if origin == nil {
+            // Start on a keyframe; audio before it has nothing to go with.
+            if video != nil && !(sample.isVideo && sample.isKeyframe) {
+                return []
+            }
+            origin = sample.decodeTime
+        }
+        guard sample.decodeTime >= origin! else {
+            return []
+        }
+        if let held = track.held {
+            track.lastDuration = max(track.scaled(sample.decodeTime - origin!) - track.scaled(held.decodeTime - origin!), 1)
+            track.samples.append(held)
+        }
+        track.held = sample
+
+        let lead = video ?? audio!
+        guard let first = lead.samples.first, let last = lead.samples.last,
+            Double(last.decodeTime - first.decodeTime) / 90000 >= fragmentDuration else {
+            return []
+        }
+        return fragment()
+    }
+
+    //MARK: Boxes
+    private func initializationSegment() -> [UInt8]? {
+        guard let expectsVideo = expectsVideo, let expectsAudio = expectsAudio,
+            !expectsVideo || videoConfig != nil, !expectsAudio || audioConfig != nil else {
+            return nil
+        }
+        var tracks: [[UInt8]] = []
+        var extends: [[UInt8]] = []
+        if let config = videoConfig, expectsVideo {
+            let track = Track(id: 1, timescale: 90000)
+            video = track
+            tracks.append(videoTrack(config, track))
+            extends.append(trackExtends(track))
+        }
+        if let config = audioConfig, expectsAudio {
+            let track = Track(id: 2, timescale: Int64(config.sampleRate))
+            audio = track
+            tracks.append(audioTrack(config, track))
+            extends.append(trackExtends(track))
+        }
+        if tracks.isEmpty {
+            failure = "no tracks"
+            return nil
+        }
+        let fileType = box("ftyp", Array("isom".utf8), u32(0x200), Array("isomiso6avc1mp41".utf8))
+        var movieHeader = u32(0) + u32(0) + u32(1000) + u32(0) + u32(0x00010000) + u16(0x0100) + [UInt8](repeating: 0, count: 10)
+        movieHeader += matrix() + [UInt8](repeating: 0, count: 24) + u32(3)
+        let movie = box("moov", fullBox("mvhd", 0, 0, movieHeader), tracks.reduce([], +), box("mvex", extends.reduce([], +)))
+        return fileType + movie
+    }
+
+    private func videoTrack(_ config: VideoConfig, _ track: Track) -> [UInt8] {
+        var entry = [UInt8](repeating: 0, count: 6) + u16(1) + [UInt8](repeating: 0, count: 16)
+        entry += u16(config.width) + u16(config.height) + u32(0x00480000) + u32(0x00480000) + u32(0) + u16(1)
+        entry += [UInt8](repeating: 0, count: 32) + u16(0x18) + u16(0xffff)
+        let sampleEntry = box("avc1", entry, box("avcC", config.avcC))
+        let media = fullBox("vmhd", 0, 1, [UInt8](repeating: 0, count: 8))
+        return self.track(track, handler: "vide", name: "VideoHandler", mediaHeader: media, sampleEntry: sampleEntry, width: config.width, height: config.height)
+    }
+
+    private func audioTrack(_ config: AudioConfig, _ track: Track) -> [UInt8] {
+        // ES descriptor: decoder config (AAC, audio stream) holding the AudioSpecificConfig, then SL config.
+        let specific = [0x05, UInt8(config.audioSpecificConfig.count)] + config.audioSpecificConfig
+        let decoderConfig = [0x04, UInt8(13 + specific.count), 0x40, 0x15, 0, 0, 0] + u32(0) + u32(0) + specific
+        let descriptor = [0x03, UInt8(3 + decoderConfig.count + 3)] + u16(Int(track.id)) + [0] + decoderConfig + [0x06, 0x01, 0x02]
+        var entry = [UInt8](repeating: 0, count: 6) + u16(1) + [UInt8](repeating: 0, count: 8)
+        entry += u16(config.channels) + u16(16) + u32(0) + u32(config.sampleRate << 16)
+        let sampleEntry = box("mp4a", entry, fullBox("esds", 0, 0, descriptor))
+        let media = fullBox("smhd", 0, 0, u32(0))
+        return self.track(track, handler: "soun", name: "SoundHandler", mediaHeader: media, sampleEntry: sampleEntry, width: 0, height: 0)
+    }
+
+    private func track(_ track: Track, handler: String, name: String, mediaHeader: [UInt8], sampleEntry: [UInt8], width: Int, height: Int) -> [UInt8] {
+        var header = u32(0) + u32(0) + u32(track.id) + u32(0) + u32(0) + [UInt8](repeating: 0, count: 8)
+        header += u16(0) + u16(0) + u16(handler == "soun" ? 0x0100 : 0) + u16(0) + matrix() + u32(width << 16) + u32(height << 16)
+        let mediaTimes = u32(0) + u32(0) + u32(Int(track.timescale)) + u32(0) + u16(0x55c4) + u16(0)
+        let handlerBox = fullBox("hdlr", 0, 0, u32(0) + Array(handler.utf8) + [UInt8](repeating: 0, count: 12) + Array(name.utf8) + [0])
+        let dataInformation = box("dinf", fullBox("dref", 0, 0, u32(1) + fullBox("url ", 0, 1, [])))
+        let sampleTable = box("stbl",
+                              fullBox("stsd", 0, 0, u32(1) + sampleEntry),
+                              fullBox("stts", 0, 0, u32(0)),
+                              fullBox("stsc", 0, 0, u32(0)),
+                              fullBox("stsz", 0, 0, u32(0) + u32(0)),
+                              fullBox("stco", 0, 0, u32(0)))
+        let media = box("mdia", fullBox("mdhd", 0, 0, mediaTimes), handlerBox, box("minf", mediaHeader, dataInformation, sampleTable))
+        return box("trak", fullBox("tkhd", 0, 3, header), media)
+    }
+
+    private func trackExtends(_ track: Track) -> [UInt8] {
+        return fullBox("trex", 0, 0, u32(track.id) + u32(1) + u32(0) + u32(0) + u32(0))
+    }
+
+    /// One `moof`/`mdat` with every track's completed samples.
+    private func fragment() -> [UInt8] {
+        let tracks = [video, audio].flatMap { $0 }.filter { !$0.samples.isEmpty }
+        guard !tracks.isEmpty, let origin = origin else {
+            return []
+        }
+        fragmentsWritten += 1
+
+        // Sizes first: the data offsets depend on the size of the moof itself.
+        func movieFragment(dataStart: Int) -> [UInt8] {
+            var offset = dataStart
+            var fragments: [[UInt8]] = []
+            for track in tracks {
+                fragments.append(trackFragment(track, origin: origin, dataOffset: offset))
+                offset += track.samples.reduce(0) { $0 + $1.data.count }
+            }
+            return box("moof", fullBox("mfhd", 0, 0, u32(fragmentsWritten)), fragments.reduce([], +))
+        }
+        let size = movieFragment(dataStart: 0).count
+        var output = movieFragment(dataStart: size + 8)
+        let dataSize = tracks.reduce(0) { total, track in total + track.samples.reduce(0) { $0 + $1.data.count } }
+        output += u32(dataSize + 8) + Array("mdat".utf8)
+        for track in tracks {
+            for sample in track.samples {
+                output += sample.data
+            }
+            track.samples = []
+        }
+        return output
+    }
+
+    private func trackFragment(_ track: Track, origin: Int64, dataOffset: Int) -> [UInt8] {
+        let isVideo = track === video
+        // data offset, duration, size, flags, and composition offsets for video.
+        let flags: UInt32 = 0x000701 | (isVideo ? 0x000800 : 0)
+        var run = u32(track.samples.count) + u32(dataOffset)
+        for (index, sample) in track.samples.enumerated() {
+            let next = index + 1 < track.samples.count ? track.samples[index + 1] : track.held
+            let duration = next.map { max(track.scaled($0.decodeTime - origin) - track.scaled(sample.decodeTime - origin), 1) } ?? track.lastDuration
+            run += u32(Int(duration)) + u32(sample.data.count)
+            run += u32(sample.isKeyframe ? 0x02000000 : 0x01010000)
+            if isVideo {
+                run += u32(Int(track.scaled(sample.compositionOffset)))
+            }
+        }
+        let decodeTime = track.scaled(track.samples[0].decodeTime - origin)
+        // Offsets count from the start of the moof.
+        return box("traf",
+                   fullBox("tfhd", 0, 0x020000, u32(Int(track.id))),
+                   fullBox("tfdt", 1, 0, u32(Int(decodeTime >> 32)) + u32(Int(decodeTime & 0xffffffff))),
+                   fullBox("trun", 0, flags, run))
+    }
+
+    //MARK: Helpers
+    private func box(_ type: String, _ payloads: [UInt8]...) -> [UInt8] {
+        let payload = payloads.reduce([], +)
+        return u32(payload.count + 8) + Array(type.utf8) + payload
+    }
+
+    private func fullBox(_ type: String, _ version: UInt8, _ flags: UInt32, _ payload: [UInt8]) -> [UInt8] {
+        return box(type, [version, UInt8(flags >> 16 & 0xff), UInt8(flags >> 8 & 0xff), UInt8(flags & 0xff)], payload)
+    }
+
+    private func matrix() -> [UInt8] {
+        return u32(0x00010000) + u32(0) + u32(0) + u32(0) + u32(0x00010000) + u32(0) + u32(0) + u32(0) + u32(0x40000000)
+    }
+
+    private func u32<T: Integer>(_ value: T) -> [UInt8] {
+        let value = value.toIntMax()
+        return [UInt8(truncatingBitPattern: value >> 24), UInt8(truncatingBitPattern: value >> 16), UInt8(truncatingBitPattern: value >> 8), UInt8(truncatingBitPattern: value)]
+    }
+
+    private func u16(_ value: Int) -> [UInt8] {
+        return [UInt8(truncatingBitPattern: value >> 8), UInt8(truncatingBitPattern: value)]
+    }
+}
@@ -0,0 +1,125 @@
+//
+//  HLSPlaylist.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// The parts of an HLS playlist the app needs: the variants of a master
+/// playlist, or the segments of a media playlist with their start times.
+struct HLSPlaylist {
+
+    struct Variant {
+        let url: URL
+        let bandwidth: Int
+        let width: Int
+        let height: Int
+    }
+
+    struct Segment {
+        let url: URL
+        let start: TimeInterval
+        let duration: TimeInterval
+    }
+
+    //MARK: Properties
+    private(set) var variants: [Variant] = []
+    private(set) var segments: [Segment] = []
+    private(set) var targetDuration: TimeInterval = 0
+    private(set) var isEndless = true
+
+    var isMaster: Bool {
+        return !variants.isEmpty
+    }
+
+    var duration: TimeInterval {
+        return segments.last.map { $0.start + $0.duration } ?? 0
+    }
+
+    //MARK: Parsing
+    init?(text: String, baseURL: URL) {
+        let lines = text.components(separatedBy: .newlines).map { $0.trimmingCharacters(in: .whitespaces) }
+        guard lines.first == "#EXTM3U" else {
+            return nil
+        }
+
+        var pendingVariant: [String: String]?
+        var pendingDuration: TimeInterval?
+        var start: TimeInterval = 0
+        for line in lines.dropFirst() where !line.isEmpty {
+            if line.hasPrefix("#EXT-X-STREAM-INF:") {
+                pendingVariant = HLSPlaylist.attributes(of: line)
+            } else if line.hasPrefix("#EXTINF:") {
+                let value = line.substring(from: line.index(line.startIndex, offsetBy: 8))
+                pendingDuration = TimeInterval(value.components(separatedBy: ",")[0].trimmingCharacters(in: .whitespaces)) ?? 0
+            } else if line.hasPrefix("#EXT-X-TARGETDURATION:") {
+                targetDuration = TimeInterval(line.substring(from: line.index(line.startIndex, offsetBy: 22))) ?? 0
+            } else if line.hasPrefix("#EXT-X-ENDLIST") {
+                isEndless = false
+            } else if !line.hasPrefix("#"), let url = URL(string: line, relativeTo: baseURL)?.absoluteURL {
+                if let attributes = pendingVariant {
+                    let resolution = (attributes["RESOLUTION"] ?? "").components(separatedBy: "x").flatMap { Int($0) }
+                    variants.append(Variant(url: url, bandwidth: Int(attributes["BANDWIDTH"] ?? "") ?? 0, width: resolution.count == 2 ? resolution[0] : 0, height: resolution.count == 2 ? resolution[1] : 0))
+                    pendingVariant = nil
+                } else if let duration = pendingDuration {
+                    segments.append(Segment(url: url, start: start, duration: duration))
+                    start += duration
+                    pendingDuration = nil
+                }
+            }
+        }
+    }
+
+    /// `KEY=VALUE` pairs after the colon of a tag, with quoted values unquoted.
+    static func attributes(of line: String) -> [String: String] {
+        guard let colon = line.characters.index(of: ":") else {
+            return [:]
+        }
+        var attributes: [String: String] = [:]
+        var key = ""
+        var value = ""
+        var readingValue = false
+        var quoted = false
+        for character in line.substring(from: line.index(after: colon)).characters {
+            if character == "\"" {
+                quoted = !quoted
+            } else if character == "=" && !readingValue {
+                readingValue = true
+            } else if character == "," && !quoted {
+                attributes[key] = value
+                key = ""
+                value = ""
+                readingValue = false
+            } else if readingValue {
+                value.append(character)
+            } else {
+                key.append(character)
+            }
+        }
+        if !key.isEmpty {
+            attributes[key] = value
+        }
+        return attributes
+    }
+
+    //MARK: Loading
+
+    /// Fetches and parses the playlist at `url`, following a master playlist
+    /// to its first variant when `followVariant` is set. Calls back on the
+    /// main thread.
+    static func load(_ url: URL, followVariant: Bool = true, completion: @escaping (HLSPlaylist?) -> Void) {
+        URLSession.shared.dataTask(with: url) { data, response, _ in
+            let playlist = data.flatMap { String(data: $0, encoding: .utf8) }.flatMap { HLSPlaylist(text: $0, baseURL: response?.url ?? url) }
+            if followVariant, let variant = playlist?.variants.first {
+                HLSPlaylist.load(variant.url, followVariant: false, completion: completion)
+                return
+            }
+            DispatchQueue.main.async {
+                completion(playlist)
+            }
+        }.resume()
+    }
+}
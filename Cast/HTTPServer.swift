@@ -0,0 +1,710 @@
+//
+//  HTTPServer.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Darwin
+import Foundation
+
+enum HTTPServerError: Error {
+    /// A socket call failed; carries `errno`.
+    case socket(Int32)
+}
+
+struct HTTPRequest {
+    let method: String
+    let path: String
+    let query: String?
+    let version: String
+    /// Header names are lowercased.
+    let headers: [String: String]
+
+    /// Whether the connection may stay open after the response.
+    var keepAlive: Bool {
+        let connection = headers["connection"]?.lowercased()
+        return version == "HTTP/1.1" ? connection != "close" : connection == "keep-alive"
+    }
+}
+
+enum HTTPBody {
+    case empty
+    case data(Data)
+    /// Sent straight from the file with `sendfile`, never read into memory.
+    case file(String)
+    /// Produced elsewhere and sent as it arrives. The stream supplies its
+    /// own status and headers; the response's headers are added to them.
+    case stream(HTTPStream)
+}
+
+struct HTTPResponse {
+    var status: Int
+    var headers: [(String, String)]
+    var body: HTTPBody
+
+    init(status: Int, headers: [(String, String)] = [], body: HTTPBody = .empty) {
+        self.status = status
+        self.headers = headers
+        self.body = body
+    }
+
+    static func error(_ status: Int) -> HTTPResponse {
+        return HTTPResponse(status: status, headers: [("Content-Type", "text/plain")], body: .data(HTTPServer.reason(for: status).data(using: .utf8)!))
+    }
+}
+
+/// Minimal HTTP/1.1 server for handing local content to a receiver.
+///
+/// One serial queue runs a non-blocking event loop over an `EventPoller`.
+/// Connections are kept alive and pipelined requests are answered in order.
+/// Single byte ranges are honoured for data and file bodies, and file bodies
+/// are written with `sendfile`, so serving a video costs no copies through
+/// user space. Stream bodies are relayed as their producer fills them. The
+/// handler runs on the loop thread and must not block.
+final class HTTPServer {
+
+    typealias Handler = (HTTPRequest) -> HTTPResponse
+
+    private final class Connection {
+        let fd: Int32
+        /// The client's IPv4 address.
+        let peer: String
+        var input: [UInt8] = []
+        var output: [UInt8] = []
+        var outputOffset = 0
+        var file: (fd: Int32, offset: off_t, remaining: off_t)?
+        var stream: HTTPStream?
+        /// Headers from the handler, sent with the stream's own once it has them.
+        var streamHeaders: [(String, String)] = []
+        var streamHeadSent = false
+        var streamSendsBody = true
+        /// Waiting for the socket to drain; streams are not pumped meanwhile.
+        var writeBlocked = false
+        var keepAlive = true
+        var lastActivity = Date()
+        /// The start of the current file body, for `onFileBodySent`.
+        var bodyStartedAt: Date?
+        var bodySent = 0
+        var bodyReported = false
+
+        init(fd: Int32, peer: String) {
+            self.fd = fd
+            self.peer = peer
+        }
+
+        var isSending: Bool {
+            return outputOffset < output.count || file != nil || stream != nil
+        }
+    }
+
+    //MARK: Properties
+    let handler: Handler
+    /// Connections waiting this long for a request are closed.
+    var idleTimeout: TimeInterval = 30
+    /// Connections whose response has not moved for this long are closed. A
+    /// paused receiver stops reading once its buffer is full, and a stream
+    /// without byte ranges cannot be picked up again after a close.
+    var stalledResponseTimeout: TimeInterval = 30 * 60
+    var maximumHeaderSize = 16 * 1024
+    private(set) var port: UInt16 = 0
+    /// How much of a file body makes a throughput sample: the start of it,
+    /// while the client still reads as fast as the network allows rather
+    /// than as its buffer empties.
+    var throughputSampleBytes = 2 << 20
+    /// Called on the loop queue with the client's address, and the bytes and
+    /// seconds of the start of each file body sent to it. The first bytes go
+    /// into the socket buffer at once, so short samples read fast.
+    var onFileBodySent: ((String, Int, TimeInterval) -> Void)?
+
+    private var listenFD: Int32 = -1
+    private var wakeFDs: [Int32] = [-1, -1]
+    private var poller: EventPoller?
+    private var connections: [Int32: Connection] = [:]
+    private let loopQueue = DispatchQueue(label: "HTTPServer")
+    private var loopFinished: DispatchSemaphore?
+    private let stopLock = NSLock()
+    private var stopRequested = false
+    private var wakePending = false
+    private var readBuffer = [UInt8](repeating: 0, count: 64 * 1024)
+
+    //MARK: Lifecycle
+    init(handler: @escaping Handler) {
+        self.handler = handler
+    }
+
+    deinit {
+        stop()
+    }
+
+    /// Binds to `port` on every interface (0 picks a free one) and starts
+    /// the event loop.
+    func start(port: UInt16 = 0) throws {
+        if loopFinished != nil {
+            return
+        }
+        let fd = socket(AF_INET, SOCK_STREAM, 0)
+        if fd < 0 {
+            throw HTTPServerError.socket(errno)
+        }
+        var yes: Int32 = 1
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, socklen_t(MemoryLayout<Int32>.size))
+
+        var address = sockaddr_in()
+        address.sin_len = UInt8(MemoryLayout<sockaddr_in>.size)
+        address.sin_family = sa_family_t(AF_INET)
+        address.sin_port = port.bigEndian
+        address.sin_addr = in_addr(s_addr: 0)
+        let bound = withUnsafePointer(to: &address) {
+            $0.withMemoryRebound(to: sockaddr.self, capacity: 1) {
+                bind(fd, $0, socklen_t(MemoryLayout<sockaddr_in>.size))
+            }
+        }
+        if bound != 0 || listen(fd, 64) != 0 {
+            let error = errno
+            HTTPServer.closeDescriptor(fd)
+            throw HTTPServerError.socket(error)
+        }
+        var length = socklen_t(MemoryLayout<sockaddr_in>.size)
+        _ = withUnsafeMutablePointer(to: &address) {
+            $0.withMemoryRebound(to: sockaddr.self, capacity: 1) {
+                getsockname(fd, $0, &length)
+            }
+        }
+        self.port = UInt16(bigEndian: address.sin_port)
+        HTTPServer.setNonBlocking(fd)
+        listenFD = fd
+
+        pipe(&wakeFDs)
+        HTTPServer.setNonBlocking(wakeFDs[0])
+        HTTPServer.setNonBlocking(wakeFDs[1])
+        let poller = makeEventPoller()
+        poller.watch(listenFD, read: true, write: false)
+        poller.watch(wakeFDs[0], read: true, write: false)
+        self.poller = poller
+
+        stopRequested = false
+        let finished = DispatchSemaphore(value: 0)
+        loopFinished = finished
+        loopQueue.async {
+            self.run()
+            finished.signal()
+        }
+    }
+
+    /// Stops the loop and closes every connection. Blocks until the loop
+    /// has finished.
+    func stop() {
+        guard let finished = loopFinished else {
+            return
+        }
+        stopLock.lock()
+        stopRequested = true
+        stopLock.unlock()
+        var byte: UInt8 = 1
+        _ = write(wakeFDs[1], &byte, 1)
+        finished.wait()
+        loopFinished = nil
+    }
+
+    /// Makes the loop look at its streams again. Safe from any thread;
+    /// wakes between two passes of the loop are coalesced.
+    private func wake() {
+        stopLock.lock()
+        if !wakePending && !stopRequested {
+            wakePending = true
+            var byte: UInt8 = 1
+            _ = write(wakeFDs[1], &byte, 1)
+        }
+        stopLock.unlock()
+    }
+
+    //MARK: Event loop
+    private func run() {
+        guard let poller = poller else {
+            return
+        }
+        while true {
+            stopLock.lock()
+            let stopping = stopRequested
+            stopLock.unlock()
+            if stopping {
+                break
+            }
+            for event in poller.wait(timeout: 1) {
+                if event.fd == listenFD {
+                    acceptConnections()
+                } else if event.fd == wakeFDs[0] {
+                    var drain = [UInt8](repeating: 0, count: 16)
+                    _ = read(wakeFDs[0], &drain, drain.count)
+                    stopLock.lock()
+                    wakePending = false
+                    stopLock.unlock()
+                } else if let connection = connections[event.fd] {
+                    if event.readable {
+                        receive(connection)
+                    }
+                    if event.writable && connections[event.fd] != nil {
+                        connection.writeBlocked = false
+                        if send(connection) {
+                            processRequests(connection)
+                        }
+                    }
+                    if event.closed && connections[event.fd] != nil && !event.readable {
+                        closeConnection(connection)
+                    }
+                }
+            }
+            pumpStreams()
+            closeIdleConnections()
+        }
+
+        for connection in Array(connections.values) {
+            closeConnection(connection)
+        }
+        poller.unwatch(listenFD)
+        poller.unwatch(wakeFDs[0])
+        HTTPServer.closeDescriptor(listenFD)
+        // Producers may still call `wake`; it checks `stopRequested` under the same lock.
+        stopLock.lock()
+        HTTPServer.closeDescriptor(wakeFDs[0])
+        HTTPServer.closeDescriptor(wakeFDs[1])
+        wakeFDs = [-1, -1]
+        stopLock.unlock()
+        self.poller = nil
+    }
+
+    private func acceptConnections() {
+        while true {
+            var address = sockaddr_in()
+            var length = socklen_t(MemoryLayout<sockaddr_in>.size)
+            let fd = withUnsafeMutablePointer(to: &address) {
+                $0.withMemoryRebound(to: sockaddr.self, capacity: 1) {
+                    accept(listenFD, $0, &length)
+                }
+            }
+            if fd < 0 {
+                return
+            }
+            var buffer = [CChar](repeating: 0, count: Int(INET_ADDRSTRLEN))
+            let peer = inet_ntop(AF_INET, &address.sin_addr, &buffer, socklen_t(buffer.count)) != nil ? String(cString: buffer) : ""
+            HTTPServer.setNonBlocking(fd)
+            var yes: Int32 = 1
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, socklen_t(MemoryLayout<Int32>.size))
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &yes, socklen_t(MemoryLayout<Int32>.size))
+            connections[fd] = Connection(fd: fd, peer: peer)
+            poller?.watch(fd, read: true, write: false)
+        }
+    }
+
+    /// Sends whatever the streams have produced since the last pass.
+    private func pumpStreams() {
+        for connection in Array(connections.values) where connection.stream != nil && !connection.writeBlocked {
+            if connections[connection.fd] != nil && send(connection) {
+                processRequests(connection)
+            }
+        }
+    }
+
+    private func closeIdleConnections() {
+        let now = Date()
+        for connection in Array(connections.values) where now.timeIntervalSince(connection.lastActivity) > (connection.isSending ? stalledResponseTimeout : idleTimeout) {
+            closeConnection(connection)
+        }
+    }
+
+    private func closeConnection(_ connection: Connection) {
+        poller?.unwatch(connection.fd)
+        if let file = connection.file {
+            HTTPServer.closeDescriptor(file.fd)
+        }
+        connection.stream?.cancel()
+        HTTPServer.closeDescriptor(connection.fd)
+        connections.removeValue(forKey: connection.fd)
+    }
+
+    //MARK: Reading
+    private func receive(_ connection: Connection) {
+        while true {
+            let count = recv(connection.fd, &readBuffer, readBuffer.count, 0)
+            if count > 0 {
+                connection.input.append(contentsOf: readBuffer[0..<count])
+                connection.lastActivity = Date()
+                continue
+            }
+            if count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break
+            }
+            // Orderly shutdown or a hard error.
+            closeConnection(connection)
+            return
+        }
+        processRequests(connection)
+    }
+
+    /// Answers every complete request in the input, one at a time, as long
+    /// as nothing is still being sent.
+    private func processRequests(_ connection: Connection) {
+        while !connection.isSending {
+            guard let end = HTTPServer.headerEnd(in: connection.input) else {
+                if connection.input.count > maximumHeaderSize {
+                    respond(connection, request: nil, response: .error(431))
+                }
+                return
+            }
+            let head = String(bytes: connection.input[0..<end], encoding: .isoLatin1) ?? ""
+            connection.input.removeFirst(end + 4)
+            guard let request = HTTPServer.parse(head) else {
+                respond(connection, request: nil, response: .error(400))
+                return
+            }
+            if request.headers["content-length"].flatMap({ Int($0) }) ?? 0 > 0 || request.headers["transfer-encoding"] != nil {
+                // Nothing here takes a body; don't try to find the next request after one.
+                respond(connection, request: nil, response: .error(413))
+                return
+            }
+            if request.method != "GET" && request.method != "HEAD" {
+                respond(connection, request: request, response: .error(405))
+            } else {
+                respond(connection, request: request, response: handler(request))
+            }
+            if connections[connection.fd] == nil {
+                return
+            }
+        }
+    }
+
+    //MARK: Writing
+    private func respond(_ connection: Connection, request: HTTPRequest?, response: HTTPResponse) {
+        var status = response.status
+        var headers = response.headers
+        connection.keepAlive = request?.keepAlive ?? false
+
+        if case .stream(let stream) = response.body {
+            // The head waits for the producer; `send` writes it once it is known.
+            connection.stream = stream
+            connection.streamHeaders = headers
+            connection.streamHeadSent = false
+            connection.streamSendsBody = request?.method != "HEAD"
+            stream.onDataAvailable = { [weak self] in
+                self?.wake()
+            }
+            _ = send(connection)
+            return
+        }
+
+        // Resolve the body to a length, and a file descriptor for files.
+        var data: Data?
+        var fileFD: Int32 = -1
+        var total: off_t = 0
+        switch response.body {
+        case .empty:
+            break
+        case .data(let bytes):
+            data = bytes
+            total = off_t(bytes.count)
+        case .stream:
+            break
+        case .file(let path):
+            fileFD = open(path, O_RDONLY)
+            var info = stat()
+            if fileFD < 0 || fstat(fileFD, &info) != 0 {
+                HTTPServer.closeDescriptor(fileFD)
+                respond(connection, request: request, response: .error(404))
+                return
+            }
+            total = info.st_size
+        }
+
+        var start: off_t = 0
+        var length = total
+        var hasBody = true
+        if case .empty = response.body {
+            hasBody = false
+        }
+        if status == 200 && hasBody {
+            headers.append(("Accept-Ranges", "bytes"))
+            if let rangeHeader = request?.headers["range"] {
+                if let range = HTTPServer.byteRange(rangeHeader, total: total) {
+                    status = 206
+                    start = range.start
+                    length = range.length
+                    headers.append(("Content-Range", "bytes \(start)-\(start + length - 1)/\(total)"))
+                } else {
+                    HTTPServer.closeDescriptor(fileFD)
+                    var unsatisfiable = HTTPResponse.error(416)
+                    unsatisfiable.headers.append(("Content-Range", "bytes */\(total)"))
+                    respond(connection, request: request, response: unsatisfiable)
+                    return
+                }
+            }
+        }
+        let sendsBody = request?.method != "HEAD"
+
+        connection.output = HTTPServer.head(status: status, headers: headers, length: length, keepAlive: connection.keepAlive)
+        connection.outputOffset = 0
+        if sendsBody, let data = data, length > 0 {
+            connection.output.append(contentsOf: data[Int(start)..<Int(start + length)])
+        }
+        if sendsBody && fileFD >= 0 && length > 0 {
+            connection.file = (fileFD, start, length)
+            connection.bodyStartedAt = nil
+            connection.bodySent = 0
+            connection.bodyReported = false
+        } else {
+            HTTPServer.closeDescriptor(fileFD)
+        }
+        _ = send(connection)
+    }
+
+    /// Writes as much as the socket takes. Returns true when the response
+    /// is complete and the connection is open for the next request.
+    private func send(_ connection: Connection) -> Bool {
+        connection.lastActivity = Date()
+        if let stream = connection.stream, !connection.streamHeadSent && !prepareStreamHead(stream, on: connection) {
+            return false
+        }
+        while connection.outputOffset < connection.output.count {
+            let count = connection.output.withUnsafeBufferPointer { buffer in
+                sendBytes(connection.fd, buffer.baseAddress! + connection.outputOffset, buffer.count - connection.outputOffset)
+            }
+            if count < 0 {
+                if errno == EAGAIN || errno == EWOULDBLOCK {
+                    connection.writeBlocked = true
+                    poller?.watch(connection.fd, read: false, write: true)
+                } else {
+                    closeConnection(connection)
+                }
+                return false
+            }
+            connection.outputOffset += count
+        }
+        connection.output = []
+        connection.outputOffset = 0
+
+        while var file = connection.file {
+            let (sent, error) = HTTPServer.sendFile(file.fd, to: connection.fd, offset: file.offset, count: min(file.remaining, 1 << 20))
+            file.offset += sent
+            file.remaining -= sent
+            connection.file = file
+            if sent > 0 {
+                noteFileBodySent(connection, Int(sent), finished: file.remaining == 0)
+            }
+            if error == EAGAIN || error == EWOULDBLOCK {
+                connection.writeBlocked = true
+                poller?.watch(connection.fd, read: false, write: true)
+                return false
+            }
+            if error != 0 || (sent == 0 && file.remaining > 0) {
+                closeConnection(connection)
+                return false
+            }
+            if file.remaining == 0 {
+                HTTPServer.closeDescriptor(file.fd)
+                connection.file = nil
+            }
+        }
+
+        if let stream = connection.stream {
+            if !sendStream(stream, on: connection) {
+                return false
+            }
+            connection.stream = nil
+            if stream.failed || stream.head?.contentLength == nil {
+                // The body was cut short, or only its end marks where it stops.
+                closeConnection(connection)
+                return false
+            }
+        }
+
+        if !connection.keepAlive {
+            closeConnection(connection)
+            return false
+        }
+        poller?.watch(connection.fd, read: true, write: false)
+        return true
+    }
+
+    private func noteFileBodySent(_ connection: Connection, _ count: Int, finished: Bool) {
+        if connection.bodyStartedAt == nil {
+            connection.bodyStartedAt = Date()
+        }
+        connection.bodySent += count
+        guard !connection.bodyReported, finished || connection.bodySent >= throughputSampleBytes, let started = connection.bodyStartedAt else {
+            return
+        }
+        connection.bodyReported = true
+        onFileBodySent?(connection.peer, connection.bodySent, Date().timeIntervalSince(started))
+    }
+
+    /// Queues the stream's head once the producer has supplied it. Returns
+    /// false while it has not.
+    private func prepareStreamHead(_ stream: HTTPStream, on connection: Connection) -> Bool {
+        guard let head = stream.head else {
+            poller?.watch(connection.fd, read: true, write: false)
+            return false
+        }
+        if head.contentLength == nil {
+            connection.keepAlive = false
+        }
+        connection.streamHeadSent = true
+        connection.output = HTTPServer.head(status: head.status, headers: head.headers + connection.streamHeaders, length: head.contentLength.map { off_t($0) }, keepAlive: connection.keepAlive)
+        connection.outputOffset = 0
+        return true
+    }
+
+    /// Writes whatever body the stream has buffered. Returns true when the
+    /// stream is finished and fully sent.
+    private func sendStream(_ stream: HTTPStream, on connection: Connection) -> Bool {
+        if !connection.streamSendsBody {
+            stream.cancel()
+            return true
+        }
+        while true {
+            var error: Int32 = 0
+            let sent = stream.consume { bytes, count in
+                let written = sendBytes(connection.fd, bytes, count)
+                if written < 0 {
+                    error = errno
+                    return 0
+                }
+                return written
+            }
+            if error == EAGAIN || error == EWOULDBLOCK {
+                connection.writeBlocked = true
+                poller?.watch(connection.fd, read: false, write: true)
+                return false
+            }
+            if error != 0 {
+                closeConnection(connection)
+                return false
+            }
+            if sent == 0 {
+                break
+            }
+            connection.lastActivity = Date()
+        }
+        if !stream.isComplete {
+            poller?.watch(connection.fd, read: true, write: false)
+            return false
+        }
+        return true
+    }
+
+    private func sendBytes(_ fd: Int32, _ bytes: UnsafePointer<UInt8>, _ count: Int) -> Int {
+        return Darwin.send(fd, bytes, count, 0)
+    }
+
+    /// Writes up to `count` bytes of `fileFD` from `offset` to the socket
+    /// without copying them through user space. Returns the bytes written
+    /// and the `errno` of a failure, or 0.
+    private static func sendFile(_ fileFD: Int32, to socketFD: Int32, offset: off_t, count: off_t) -> (off_t, Int32) {
+        var length = count
+        // On EAGAIN Darwin still reports the partial length in `length`.
+        let result = Darwin.sendfile(fileFD, socketFD, offset, &length, nil, 0)
+        return (length, result == 0 ? 0 : errno)
+    }
+
+    /// Status line and headers; the length is left out when it is not known.
+    private static func head(status: Int, headers: [(String, String)], length: off_t?, keepAlive: Bool) -> [UInt8] {
+        var head = "HTTP/1.1 \(status) \(reason(for: status))\r\n"
+        for (name, value) in headers {
+            head += "\(name): \(value)\r\n"
+        }
+        if let length = length {
+            head += "Content-Length: \(length)\r\n"
+        }
+        head += "Connection: \(keepAlive ? "keep-alive" : "close")\r\n\r\n"
+        return Array(head.utf8)
+    }
+
+    //MARK: Parsing
+    private static func headerEnd(in bytes: [UInt8]) -> Int? {
+        if bytes.count < 4 {
+            return nil
+        }
+        for index in 0...(bytes.count - 4) where bytes[index] == 13 && bytes[index + 1] == 10 && bytes[index + 2] == 13 && bytes[index + 3] == 10 {
+            return index
+        }
+        return nil
+    }
+
+    static func parse(_ head: String) -> HTTPRequest? {
+        var lines = head.components(separatedBy: "\r\n")
+        let requestLine = lines.removeFirst().components(separatedBy: " ")
+        guard requestLine.count == 3, requestLine[2].hasPrefix("HTTP/") else {
+            return nil
+        }
+        var headers: [String: String] = [:]
+        for line in lines {
+            guard let colon = line.range(of: ":") else {
+                continue
+            }
+            let name = line.substring(to: colon.lowerBound).trimmingCharacters(in: .whitespaces).lowercased()
+            headers[name] = line.substring(from: colon.upperBound).trimmingCharacters(in: .whitespaces)
+        }
+        let target = requestLine[1].components(separatedBy: "?")
+        let path = target[0].removingPercentEncoding ?? target[0]
+        return HTTPRequest(method: requestLine[0], path: path, query: target.count > 1 ? target[1] : nil, version: requestLine[2], headers: headers)
+    }
+
+    /// The single range of `header` within `total` bytes, or nil when it
+    /// cannot be satisfied. Multiple ranges are answered with the first.
+    static func byteRange(_ header: String, total: off_t) -> (start: off_t, length: off_t)? {
+        guard header.hasPrefix("bytes="), total > 0 else {
+            return nil
+        }
+        let spec = header.substring(from: header.index(header.startIndex, offsetBy: 6)).components(separatedBy: ",")[0]
+        let parts = spec.components(separatedBy: "-")
+        guard parts.count == 2 else {
+            return nil
+        }
+        let first = parts[0].trimmingCharacters(in: .whitespaces)
+        let last = parts[1].trimmingCharacters(in: .whitespaces)
+        if first.isEmpty {
+            // Suffix range: the last N bytes.
+            guard let suffix = off_t(last), suffix > 0 else {
+                return nil
+            }
+            let length = min(suffix, total)
+            return (total - length, length)
+        }
+        guard let start = off_t(first), start < total else {
+            return nil
+        }
+        let end = last.isEmpty ? total - 1 : min(off_t(last) ?? -1, total - 1)
+        if end < start {
+            return nil
+        }
+        return (start, end - start + 1)
+    }
+
+    static func reason(for status: Int) -> String {
+        switch status {
+        case 200: return "OK"
+        case 206: return "Partial Content"
+        case 302: return "Found"
+        case 400: return "Bad Request"
+        case 403: return "Forbidden"
+        case 404: return "Not Found"
+        case 405: return "Method Not Allowed"
+        case 413: return "Payload Too Large"
+        case 416: return "Range Not Satisfiable"
+        case 431: return "Request Header Fields Too Large"
+        case 502: return "Bad Gateway"
+        default: return "Status \(status)"
+        }
+    }
+
+    //MARK: Helpers
+    private static func setNonBlocking(_ fd: Int32) {
+        _ = fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK)
+    }
+
+    fileprivate static func closeDescriptor(_ fd: Int32) {
+        if fd >= 0 {
+            _ = Darwin.close(fd)
+        }
+    }
+}
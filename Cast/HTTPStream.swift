@@ -0,0 +1,261 @@
+//
+//  HTTPStream.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// Fixed-size byte buffers shared by every stream, so proxying costs a
+/// bounded amount of memory however many connections are open.
+final class BufferPool {
+
+    static let shared = BufferPool(bufferSize: 64 * 1024, maximumBuffers: 256)
+
+    final class Buffer {
+        let bytes: UnsafeMutablePointer<UInt8>
+        let capacity: Int
+        /// Filled bytes are `start..<end`.
+        var start = 0
+        var end = 0
+
+        fileprivate init(capacity: Int) {
+            bytes = UnsafeMutablePointer<UInt8>.allocate(capacity: capacity)
+            self.capacity = capacity
+        }
+
+        deinit {
+            bytes.deallocate(capacity: capacity)
+        }
+    }
+
+    //MARK: Properties
+    let bufferSize: Int
+    let maximumBuffers: Int
+    private let lock = NSLock()
+    private var free: [Buffer] = []
+    private var allocated = 0
+
+    init(bufferSize: Int, maximumBuffers: Int) {
+        self.bufferSize = bufferSize
+        self.maximumBuffers = maximumBuffers
+    }
+
+    //MARK: Methods
+
+    /// An empty buffer, or nil when every buffer is in use.
+    func acquire() -> Buffer? {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        if let buffer = free.popLast() {
+            return buffer
+        }
+        if allocated == maximumBuffers {
+            return nil
+        }
+        allocated += 1
+        return Buffer(capacity: bufferSize)
+    }
+
+    func release(_ buffer: Buffer) {
+        buffer.start = 0
+        buffer.end = 0
+        lock.lock()
+        free.append(buffer)
+        lock.unlock()
+    }
+}
+
+/// A response body produced on another thread and sent as it arrives.
+///
+/// The producer supplies the head once it knows it, then writes data until
+/// `finish`. Data is held in pool buffers up to `capacity`; past that `write`
+/// returns false and the producer should pause until `onSpaceAvailable`.
+/// The server drains the stream with `consume`. Thread safe.
+final class HTTPStream {
+
+    struct Head {
+        let status: Int
+        let headers: [(String, String)]
+        /// Nil when the length is not known up front.
+        let contentLength: Int64?
+    }
+
+    //MARK: Properties
+    let capacity: Int
+    /// Called on the consumer's thread once a paused producer may write again.
+    var onSpaceAvailable: (() -> Void)?
+    /// Called on the consumer's thread if it goes away before the end.
+    var onCancel: (() -> Void)?
+    /// Called on the producer's thread whenever there is something new to send.
+    var onDataAvailable: (() -> Void)?
+
+    private let pool: BufferPool
+    private let lock = NSLock()
+    private var storedHead: Head?
+    private var buffers: [BufferPool.Buffer] = []
+    private var overflow = Data()
+    private var buffered = 0
+    private var paused = false
+    private var finished = false
+    private var storedFailed = false
+    private var cancelled = false
+
+    init(capacity: Int = 1 << 20, pool: BufferPool = .shared) {
+        self.capacity = capacity
+        self.pool = pool
+    }
+
+    deinit {
+        for buffer in buffers {
+            pool.release(buffer)
+        }
+    }
+
+    var head: Head? {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        return storedHead
+    }
+
+    /// The producer has finished and everything written has been consumed.
+    var isComplete: Bool {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        return finished && buffered == 0 && overflow.isEmpty
+    }
+
+    var failed: Bool {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        return storedFailed
+    }
+
+    //MARK: Producing
+    func respond(_ head: Head) {
+        lock.lock()
+        if storedHead == nil {
+            storedHead = head
+        }
+        lock.unlock()
+        onDataAvailable?()
+    }
+
+    /// Queues `data`. Returns false once the stream is full; the data is
+    /// still kept, but nothing more should be written until `onSpaceAvailable`.
+    @discardableResult
+    func write(_ data: Data) -> Bool {
+        lock.lock()
+        if cancelled {
+            lock.unlock()
+            return true
+        }
+        if overflow.isEmpty {
+            let written = fill(from: data)
+            if written < data.count {
+                overflow = data.subdata(in: written..<data.count)
+            }
+        } else {
+            overflow.append(data)
+        }
+        paused = paused || !overflow.isEmpty || buffered >= capacity
+        let accepting = !paused
+        lock.unlock()
+        onDataAvailable?()
+        return accepting
+    }
+
+    func finish(failed: Bool = false) {
+        lock.lock()
+        finished = true
+        storedFailed = storedFailed || failed
+        lock.unlock()
+        onDataAvailable?()
+    }
+
+    /// Copies as much of `data` into pool buffers as the capacity and the
+    /// pool allow. Call with the lock held.
+    private func fill(from data: Data) -> Int {
+        var written = 0
+        while written < data.count && buffered < capacity {
+            if buffers.last.map({ $0.end == $0.capacity }) ?? true {
+                guard let buffer = pool.acquire() else {
+                    break
+                }
+                buffers.append(buffer)
+            }
+            let buffer = buffers.last!
+            let count = min(buffer.capacity - buffer.end, data.count - written, capacity - buffered)
+            data.copyBytes(to: buffer.bytes + buffer.end, from: written..<(written + count))
+            buffer.end += count
+            buffered += count
+            written += count
+        }
+        return written
+    }
+
+    //MARK: Consuming
+
+    /// Offers the oldest buffered bytes to `send`, which returns how many it
+    /// took. Returns the total taken.
+    func consume(_ send: (UnsafePointer<UInt8>, Int) -> Int) -> Int {
+        var resume: (() -> Void)?
+        lock.lock()
+        var total = 0
+        while let buffer = buffers.first, buffer.end > buffer.start {
+            let available = buffer.end - buffer.start
+            let sent = send(buffer.bytes + buffer.start, available)
+            if sent <= 0 {
+                break
+            }
+            buffer.start += sent
+            buffered -= sent
+            total += sent
+            if buffer.start == buffer.end {
+                buffers.removeFirst()
+                pool.release(buffer)
+            }
+            if sent < available {
+                break
+            }
+        }
+        if paused && buffered < capacity / 2 {
+            let moved = fill(from: overflow)
+            overflow = moved < overflow.count ? overflow.subdata(in: moved..<overflow.count) : Data()
+            if overflow.isEmpty {
+                paused = false
+                resume = onSpaceAvailable
+            }
+        }
+        lock.unlock()
+        resume?()
+        return total
+    }
+
+    /// The consumer is gone; drops the buffers and tells the producer.
+    func cancel() {
+        lock.lock()
+        let wasCancelled = cancelled
+        cancelled = true
+        for buffer in buffers {
+            pool.release(buffer)
+        }
+        buffers = []
+        overflow = Data()
+        buffered = 0
+        lock.unlock()
+        if !wasCancelled {
+            onCancel?()
+        }
+    }
+}
@@ -0,0 +1,115 @@
+//
+//  HandoffController.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import UIKit
+import WebKit
+import GoogleCast
+
+/// Moves the video playing in the browser to the TV without losing its place.
+///
+/// The page's media element is asked for its source and current time, and
+/// the receiver is told to start that far in plus the median load latency,
+/// which is how far the page will have played by the time the TV starts.
+/// The page is paused only once the receiver reports playing. At that
+/// moment the local and receiver positions are compared; the difference is
+/// the continuity gap, positive when content was skipped.
+final class HandoffController {
+
+    static let shared = HandoffController()
+
+    /// Finds the playing media element, or the first one, marks it for the
+    /// second step and describes it as JSON.
+    private static let inspectScript = "(function(){var all=[].slice.call(document.querySelectorAll('video,audio'));var m=all.filter(function(e){return !e.paused;})[0]||all[0];if(!m){return '';}all.forEach(function(e){e.removeAttribute('data-cast-handoff');});m.setAttribute('data-cast-handoff','1');return JSON.stringify({src:m.currentSrc||m.src,time:m.currentTime,paused:m.paused});})()"
+    private static let pauseScript = "(function(){var m=document.querySelector('[data-cast-handoff]');if(!m){return '';}m.pause();return String(m.currentTime);})()"
+
+    //MARK: Properties
+    /// How long to wait for the receiver to start playing before giving up.
+    var timeout: TimeInterval = 20
+
+    private(set) var continuityGaps = LatencyHistogram()
+    private(set) var lastContinuityGap: TimeInterval?
+
+    private weak var webView: WKWebView?
+    private var subscription: MediaStatusSubscription?
+    private var contentID: String?
+    /// The receiver's media session before the load, so an earlier session
+    /// playing the same URL is not taken for the new one.
+    private var previousMediaSessionID = 0
+
+    //MARK: Methods
+
+    /// Starts the handoff of the media playing in `webView`, once the page
+    /// has described it. Does nothing if the page has no media element, and
+    /// shows the cast dialog if there is nothing to cast to.
+    func handoff(from webView: WKWebView) {
+        guard CastController.shared.remoteMediaClient != nil else {
+            GCKCastContext.sharedInstance().presentCastDialog()
+            return
+        }
+        let pageTitle = webView.title ?? ""
+        let pageURL = webView.url?.absoluteString ?? ""
+        webView.evaluateJavaScript(HandoffController.inspectScript) { [weak self, weak webView] result, _ in
+            guard let json = result as? String, let data = json.data(using: .utf8),
+                let media = (try? JSONSerialization.jsonObject(with: data)) as? [String: Any],
+                let source = media["src"] as? String, !source.isEmpty,
+                let item = MediaLibrary.shared.add(url: source, pageTitle: pageTitle, pageURL: pageURL),
+                let webView = webView else {
+                return
+            }
+            self?.start(item, at: media["time"] as? Double ?? 0, paused: media["paused"] as? Bool ?? true, from: webView)
+        }
+    }
+
+    private func start(_ item: MediaItem, at time: TimeInterval, paused: Bool, from webView: WKWebView) {
+        let lead = paused ? 0 : CastRequestTracker.shared.histograms[.load]?.value(atPercentile: 50) ?? 0
+
+        cancel()
+        self.webView = webView
+        let information = MediaInformationCache.shared.information(for: item)
+        contentID = information.contentID
+        previousMediaSessionID = MediaStatusHub.shared.snapshot.mediaSessionID
+        CastController.shared.load(information, autoplay: true, playPosition: time + lead, completion: ReceiverPrewarmer.shared.timingFirstLoad(of: item, { [weak self] outcome in
+            if case .completed = outcome {
+                return
+            }
+            self?.cancel()
+        }))
+        subscription = MediaStatusHub.shared.subscribe([.playerState, .media]) { [weak self] snapshot, _ in
+            self?.statusDidChange(snapshot)
+        }
+        DispatchQueue.main.asyncAfter(deadline: .now() + timeout) { [weak self] in
+            if self?.contentID == information.contentID {
+                self?.cancel()
+            }
+        }
+    }
+
+    func cancel() {
+        subscription = nil
+        contentID = nil
+        webView = nil
+    }
+
+    private func statusDidChange(_ snapshot: MediaStatusSnapshot) {
+        guard snapshot.playerState == .playing, snapshot.contentID == contentID, snapshot.mediaSessionID != previousMediaSessionID else {
+            return
+        }
+        // Projected from the snapshot itself, to the moment the page answers;
+        // the clock may not have seen this update yet.
+        webView?.evaluateJavaScript(HandoffController.pauseScript) { [weak self] result, _ in
+            guard let local = result as? String, let localPosition = TimeInterval(local) else {
+                return
+            }
+            let elapsed = CACurrentMediaTime() - snapshot.receivedAt + CastRequestTracker.shared.oneWayDelay
+            let gap = snapshot.streamPosition + elapsed * Double(snapshot.playbackRate) - localPosition
+            self?.lastContinuityGap = gap
+            self?.continuityGaps.record(abs(gap))
+        }
+        cancel()
+    }
+}
@@ -0,0 +1,112 @@
+//
+//  LatencyHistogram.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// Log-linear histogram of durations in the spirit of HdrHistogram.
+///
+/// Values are kept in microseconds. Below 64 µs every value has its own
+/// bucket; above that every power of two is split into 32 linear
+/// sub-buckets, which bounds the relative error of any percentile to about
+/// 3% while covering up to roughly 12 days in under 1.2k counters.
+struct LatencyHistogram {
+
+    private static let subBucketBits: UInt64 = 5
+    private static let subBucketCount = 1 << Int(subBucketBits)
+    private static let linearLimit = subBucketCount * 2
+    private static let maxExponent = 40
+
+    //MARK: Properties
+    private var counts = [UInt64](repeating: 0, count: LatencyHistogram.linearLimit + (LatencyHistogram.maxExponent - 5) * LatencyHistogram.subBucketCount)
+    private(set) var count: UInt64 = 0
+    private(set) var minimum: TimeInterval = 0
+    private(set) var maximum: TimeInterval = 0
+    private var sum: TimeInterval = 0
+
+    var mean: TimeInterval {
+        return count == 0 ? 0 : sum / Double(count)
+    }
+
+    //MARK: Recording
+    mutating func record(_ duration: TimeInterval) {
+        let seconds = max(0, duration)
+        counts[LatencyHistogram.bucket(for: UInt64(seconds * 1_000_000))] += 1
+        minimum = count == 0 ? seconds : min(minimum, seconds)
+        maximum = max(maximum, seconds)
+        sum += seconds
+        count += 1
+    }
+
+    mutating func reset() {
+        self = LatencyHistogram()
+    }
+
+    //MARK: Querying
+
+    /// Duration below which `percentile` percent of the samples fall.
+    func value(atPercentile percentile: Double) -> TimeInterval {
+        if count == 0 {
+            return 0
+        }
+        let target = max(1, UInt64((Double(count) * percentile / 100).rounded(.up)))
+        var seen: UInt64 = 0
+        for (bucket, bucketCount) in counts.enumerated() where bucketCount > 0 {
+            seen += bucketCount
+            if seen >= target {
+                return min(maximum, max(minimum, LatencyHistogram.midpoint(of: bucket)))
+            }
+        }
+        return maximum
+    }
+
+    /// Summary suitable for JSON export.
+    func summary() -> [String: Any] {
+        return [
+            "count": count,
+            "min_ms": minimum * 1000,
+            "mean_ms": mean * 1000,
+            "p50_ms": value(atPercentile: 50) * 1000,
+            "p90_ms": value(atPercentile: 90) * 1000,
+            "p99_ms": value(atPercentile: 99) * 1000,
+            "max_ms": maximum * 1000
+        ]
+    }
+
+    //MARK: Buckets
+    private static func bucket(for microseconds: UInt64) -> Int {
+        if microseconds < UInt64(linearLimit) {
+            return Int(microseconds)
+        }
+        let exponent = min(maxExponent - 1, 63 - leadingZeros(microseconds))
+        let shift = UInt64(exponent) - subBucketBits
+        let mantissa = Int(min(microseconds >> shift, UInt64(subBucketCount * 2 - 1)))
+        return linearLimit + (exponent - Int(subBucketBits) - 1) * subBucketCount + (mantissa - subBucketCount)
+    }
+
+    private static func midpoint(of bucket: Int) -> TimeInterval {
+        if bucket < linearLimit {
+            return Double(bucket) / 1_000_000
+        }
+        let exponent = UInt64((bucket - linearLimit) / subBucketCount) + subBucketBits + 1
+        let mantissa = UInt64((bucket - linearLimit) % subBucketCount + subBucketCount)
+        let shift = exponent - subBucketBits
+        let lower = mantissa << shift
+        let width = UInt64(1) << shift
+        return (Double(lower) + Double(width) / 2) / 1_000_000
+    }
+
+    private static func leadingZeros(_ value: UInt64) -> Int {
+        var zeros = 0
+        var probe = value
+        while probe & (UInt64(1) << 63) == 0 && zeros < 64 {
+            probe <<= 1
+            zeros += 1
+        }
+        return zeros
+    }
+}
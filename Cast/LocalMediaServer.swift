@@ -0,0 +1,332 @@
+//
+//  LocalMediaServer.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+
+/// Serves the app's content to receivers on the local network.
+///
+/// Files copied into the app's Documents folder through iTunes file sharing
+/// are published to the media library under `/files/`. Other parts of the
+/// app add their own path prefixes with `register(_:handler:)`. Handlers
+/// run on the server's loop queue, not the main thread.
+final class LocalMediaServer {
+
+    static let shared = LocalMediaServer()
+    static let preferredPort: UInt16 = 8090
+    static let filesPrefix = "/files/"
+
+    //MARK: Properties
+    let documentsURL = FileManager.default.urls(for: .documentDirectory, in: .userDomainMask)[0]
+    private var server: HTTPServer?
+    private let routesLock = NSLock()
+    private var routes: [(prefix: String, handler: HTTPServer.Handler)] = []
+
+    var port: UInt16 {
+        return server?.port ?? 0
+    }
+
+    /// `http://<wifi address>:<port>`, or nil without Wi-Fi or a running server.
+    var baseURL: String? {
+        guard let server = server, let address = LocalMediaServer.wifiAddress() else {
+            return nil
+        }
+        return "http://\(address):\(server.port)"
+    }
+
+    //MARK: Lifecycle
+    init() {
+        let documentsURL = self.documentsURL
+        register(LocalMediaServer.filesPrefix) { request in
+            LocalMediaServer.serveDocument(request, from: documentsURL)
+        }
+    }
+
+    @discardableResult
+    func start() -> Bool {
+        if server != nil {
+            return true
+        }
+        let server = HTTPServer { [weak self] request in
+            self?.route(request) ?? .error(503)
+        }
+        // Files come off the disk faster than Wi-Fi takes them, so sending one is a measure of the link.
+        server.onFileBodySent = { peer, bytes, seconds in
+            DeviceProber.shared.recordTransfer(bytes: bytes, seconds: seconds, to: peer)
+        }
+        do {
+            try server.start(port: LocalMediaServer.preferredPort)
+        } catch {
+            // Someone else has the port; any port will do.
+            do {
+                try server.start(port: 0)
+            } catch {
+                return false
+            }
+        }
+        self.server = server
+        return true
+    }
+
+    func stop() {
+        server?.stop()
+        server = nil
+    }
+
+    //MARK: Routing
+
+    /// Sends requests whose path starts with `prefix` to `handler`.
+    func register(_ prefix: String, handler: @escaping HTTPServer.Handler) {
+        routesLock.lock()
+        routes = routes.filter { $0.prefix != prefix } + [(prefix, handler)]
+        routesLock.unlock()
+    }
+
+    func unregister(_ prefix: String) {
+        routesLock.lock()
+        routes = routes.filter { $0.prefix != prefix }
+        routesLock.unlock()
+    }
+
+    private func route(_ request: HTTPRequest) -> HTTPResponse {
+        routesLock.lock()
+        let handler = routes.first { request.path.hasPrefix($0.prefix) }?.handler
+        routesLock.unlock()
+        var response = handler?(request) ?? .error(404)
+        // Receivers fetch through a web player, which checks CORS for anything beyond plain video.
+        response.headers.append(("Access-Control-Allow-Origin", "*"))
+        return response
+    }
+
+    //MARK: Documents
+
+    /// Adds every playable file in Documents to the media library.
+    func publishDocuments() {
+        guard let baseURL = baseURL,
+            let names = try? FileManager.default.contentsOfDirectory(atPath: documentsURL.path) else {
+            return
+        }
+        for name in names.sorted() where !MediaLibrary.contentType(forPathExtension: NSString(string: name).pathExtension).isEmpty {
+            let path = name.addingPercentEncoding(withAllowedCharacters: .urlPathAllowed) ?? name
+            MediaLibrary.shared.add(url: baseURL + LocalMediaServer.filesPrefix + path, pageTitle: "On this iPhone")
+        }
+    }
+
+    private static func serveDocument(_ request: HTTPRequest, from documentsURL: URL) -> HTTPResponse {
+        let name = request.path.substring(from: request.path.index(request.path.startIndex, offsetBy: filesPrefix.characters.count))
+        // Only plain names inside Documents, never a way out of it.
+        if name.isEmpty || name.contains("/") || name.hasPrefix(".") {
+            return .error(403)
+        }
+        let path = documentsURL.appendingPathComponent(name).path
+        let contentType = MediaLibrary.contentType(forPathExtension: NSString(string: name).pathExtension)
+        return HTTPResponse(status: 200, headers: [("Content-Type", contentType.isEmpty ? "application/octet-stream" : contentType)], body: .file(path))
+    }
+
+    //MARK: Network
+
+    /// IPv4 address of the Wi-Fi interface, which is what a receiver can reach.
+    static func wifiAddress() -> String? {
+        var interfaces: UnsafeMutablePointer<ifaddrs>?
+        guard getifaddrs(&interfaces) == 0 else {
+            return nil
+        }
+        defer {
+            freeifaddrs(interfaces)
+        }
+        var cursor = interfaces
+        while let interface = cursor?.pointee {
+            cursor = interface.ifa_next
+            guard let address = interface.ifa_addr, address.pointee.sa_family == sa_family_t(AF_INET),
+                String(cString: interface.ifa_name) == "en0" else {
+                continue
+            }
+            var host = [CChar](repeating: 0, count: Int(NI_MAXHOST))
+            if getnameinfo(address, socklen_t(address.pointee.sa_len), &host, socklen_t(host.count), nil, 0, NI_NUMERICHOST) == 0 {
+                return String(cString: host)
+            }
+        }
+        return nil
+    }
+
+    /// The Wi-Fi network as `address/prefix`, which tells networks apart
+    /// without the entitlement reading the SSID needs.
+    static func wifiSubnet() -> String? {
+        var interfaces: UnsafeMutablePointer<ifaddrs>?
+        guard getifaddrs(&interfaces) == 0 else {
+            return nil
+        }
+        defer {
+            freeifaddrs(interfaces)
+        }
+        var cursor = interfaces
+        while let interface = cursor?.pointee {
+            cursor = interface.ifa_next
+            guard let address = interface.ifa_addr, let netmask = interface.ifa_netmask,
+                address.pointee.sa_family == sa_family_t(AF_INET), String(cString: interface.ifa_name) == "en0" else {
+                continue
+            }
+            let host = address.withMemoryRebound(to: sockaddr_in.self, capacity: 1) { UInt32(bigEndian: $0.pointee.sin_addr.s_addr) }
+            let mask = netmask.withMemoryRebound(to: sockaddr_in.self, capacity: 1) { UInt32(bigEndian: $0.pointee.sin_addr.s_addr) }
+            let network = host & mask
+            var prefix = 0
+            var bits = mask
+            while bits != 0 {
+                prefix += Int(bits & 1)
+                bits >>= 1
+            }
+            return "\(network >> 24).\((network >> 16) & 0xff).\((network >> 8) & 0xff).\(network & 0xff)/\(prefix)"
+        }
+        return nil
+    }
+
+    //MARK: Benchmark
+
+    /// Measures loopback throughput: `requests` keep-alive GETs of a
+    /// `megabytes` file, then as many 1 MB range requests at random offsets.
+    /// Runs off the main thread and calls back on it.
+    func measureThroughput(megabytes: Int = 64, requests: Int = 4, completion: @escaping ([String: Any]) -> Void) {
+        start()
+        let port = self.port
+        DispatchQueue.global(qos: .utility).async {
+            let url = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("throughput.bin")
+            let size = megabytes << 20
+            let attributes = try? FileManager.default.attributesOfItem(atPath: url.path)
+            if (attributes?[.size] as? NSNumber)?.intValue != size {
+                FileManager.default.createFile(atPath: url.path, contents: nil, attributes: nil)
+                if let handle = try? FileHandle(forWritingTo: url) {
+                    let chunk = Data(count: 1 << 20)
+                    for _ in 0..<megabytes {
+                        handle.write(chunk)
+                    }
+                    handle.closeFile()
+                }
+            }
+            self.register("/throughput") { _ in
+                HTTPResponse(status: 200, headers: [("Content-Type", "application/octet-stream")], body: .file(url.path))
+            }
+            defer {
+                self.unregister("/throughput")
+            }
+
+            var results: [String: Any] = [:]
+            let client = BenchmarkClient(port: port)
+            var started = CACurrentMediaTime()
+            var bytes = 0
+            for _ in 0..<requests {
+                bytes += client?.get("/throughput") ?? 0
+            }
+            var seconds = CACurrentMediaTime() - started
+            results["full"] = ["bytes": bytes, "seconds": seconds, "mb_per_second": Double(bytes) / 1_048_576 / max(seconds, 1e-9)]
+
+            started = CACurrentMediaTime()
+            bytes = 0
+            for _ in 0..<requests {
+                let offset = Int(arc4random_uniform(UInt32(max(1, megabytes - 1)))) << 20
+                bytes += client?.get("/throughput", range: "bytes=\(offset)-\(offset + (1 << 20) - 1)") ?? 0
+            }
+            seconds = CACurrentMediaTime() - started
+            results["ranged"] = ["bytes": bytes, "seconds": seconds, "mb_per_second": Double(bytes) / 1_048_576 / max(seconds, 1e-9)]
+            client?.close()
+
+            DispatchQueue.main.async {
+                completion(results)
+            }
+        }
+    }
+}
+
+/// Blocking keep-alive HTTP client for the loopback benchmark.
+private final class BenchmarkClient {
+
+    private let fd: Int32
+    private var buffer = [UInt8](repeating: 0, count: 256 * 1024)
+    private var pending: [UInt8] = []
+
+    init?(port: UInt16) {
+        let socketFD = socket(AF_INET, SOCK_STREAM, 0)
+        fd = socketFD
+        var address = sockaddr_in()
+        address.sin_len = UInt8(MemoryLayout<sockaddr_in>.size)
+        address.sin_family = sa_family_t(AF_INET)
+        address.sin_port = port.bigEndian
+        address.sin_addr = in_addr(s_addr: UInt32(0x7f000001).bigEndian)
+        let connected = withUnsafePointer(to: &address) {
+            $0.withMemoryRebound(to: sockaddr.self, capacity: 1) {
+                connect(socketFD, $0, socklen_t(MemoryLayout<sockaddr_in>.size))
+            }
+        }
+        if socketFD < 0 || connected != 0 {
+            Darwin.close(socketFD)
+            return nil
+        }
+        var yes: Int32 = 1
+        setsockopt(socketFD, SOL_SOCKET, SO_NOSIGPIPE, &yes, socklen_t(MemoryLayout<Int32>.size))
+    }
+
+    /// Sends one GET and reads the whole body. Returns the body length.
+    func get(_ path: String, range: String? = nil) -> Int {
+        var request = "GET \(path) HTTP/1.1\r\nHost: localhost\r\n"
+        if let range = range {
+            request += "Range: \(range)\r\n"
+        }
+        request += "\r\n"
+        let bytes = Array(request.utf8)
+        if send(fd, bytes, bytes.count, 0) != bytes.count {
+            return 0
+        }
+
+        // Read up to the end of the head, then count off the body.
+        var head: [UInt8] = pending
+        pending = []
+        var headEnd: Int?
+        while headEnd == nil {
+            if let end = BenchmarkClient.find([13, 10, 13, 10], in: head) {
+                headEnd = end
+                break
+            }
+            let count = recv(fd, &buffer, buffer.count, 0)
+            if count <= 0 {
+                return 0
+            }
+            head.append(contentsOf: buffer[0..<count])
+        }
+        let headText = String(bytes: head[0..<headEnd!], encoding: .isoLatin1) ?? ""
+        var length = 0
+        for line in headText.components(separatedBy: "\r\n") where line.lowercased().hasPrefix("content-length:") {
+            length = Int(line.substring(from: line.index(line.startIndex, offsetBy: 15)).trimmingCharacters(in: .whitespaces)) ?? 0
+        }
+        var remaining = length - (head.count - headEnd! - 4)
+        if remaining < 0 {
+            pending = Array(head[(head.count + remaining)..<head.count])
+            remaining = 0
+        }
+        while remaining > 0 {
+            let count = recv(fd, &buffer, min(buffer.count, remaining), 0)
+            if count <= 0 {
+                return length - remaining
+            }
+            remaining -= count
+        }
+        return length
+    }
+
+    func close() {
+        Darwin.close(fd)
+    }
+
+    private static func find(_ pattern: [UInt8], in bytes: [UInt8]) -> Int? {
+        if bytes.count < pattern.count {
+            return nil
+        }
+        for index in 0...(bytes.count - pattern.count) where Array(bytes[index..<(index + pattern.count)]) == pattern {
+            return index
+        }
+        return nil
+    }
+}
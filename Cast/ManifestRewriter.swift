@@ -0,0 +1,428 @@
+//
+//  ManifestRewriter.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// Rewrites an HLS playlist or DASH manifest as it streams through the proxy.
+///
+/// Every link is resolved against the manifest, or the DASH `BaseURL` in
+/// effect, and pointed back through the proxy, so segments keep the page's
+/// headers and can be read ahead. Variants bigger than the receiver's
+/// limits are dropped, and an HLS master playlist is reordered so the
+/// receiver starts on a variant it can fetch quickly. Only a line of HLS or
+/// one `AdaptationSet` of DASH is held at a time, which keeps the work small
+/// enough to redo on every live refresh. Not thread safe; feed it from one queue.
+final class ManifestRewriter {
+
+    enum Format {
+        case hls
+        case dash
+    }
+
+    /// One HLS variant with its tags, or one DASH `Representation` with its children.
+    private struct Variant {
+        var id: Int
+        var parts: [String]
+        var bandwidth: Int
+        var width: Int
+        var height: Int
+    }
+
+    /// An open DASH `AdaptationSet`: text, and slots for its representations.
+    private enum Part {
+        case text(String)
+        case variant(Int)
+    }
+
+    //MARK: Properties
+    let format: Format
+    private let baseURL: URL
+    private let referer: String
+    private let limits: VariantPolicy.Limits
+    private var pending: [UInt8] = []
+    private var output = Data()
+
+    // HLS
+    private var variantTags: [String]?
+    private var variants: [Variant] = []
+    private var expectingSegment = false
+
+    // DASH
+    private var scanned = 0
+    private var tagQuote: UInt8?
+    private var inTag = false
+    private var inBaseURL = false
+    /// Elements open around the current token.
+    private var depth = 0
+    /// `BaseURL`s in effect, each with the depth of the element that holds it.
+    private var bases: [(depth: Int, url: URL)] = []
+    private var adaptationSet: [Part]?
+    private var representation: Variant?
+
+    /// Segment URLs of an HLS media playlist, resolved against the original.
+    private(set) var segments: [URL] = []
+    /// HLS without `#EXT-X-ENDLIST`, or a dynamic DASH manifest.
+    private(set) var isLive = false
+    private(set) var variantsDropped = 0
+    private var sawEndList = false
+
+    //MARK: Lifecycle
+    init(format: Format, baseURL: URL, referer: String, limits: VariantPolicy.Limits) {
+        self.format = format
+        self.baseURL = baseURL
+        self.referer = referer
+        self.limits = limits
+    }
+
+    /// The manifest format of a response, or nil for anything else.
+    static func format(contentType: String, url: URL?) -> Format? {
+        let type = contentType.lowercased()
+        let pathExtension = url?.pathExtension.lowercased() ?? ""
+        if type.contains("mpegurl") || pathExtension == "m3u8" {
+            return .hls
+        }
+        if type.contains("dash+xml") || pathExtension == "mpd" {
+            return .dash
+        }
+        return nil
+    }
+
+    //MARK: Methods
+    func append(_ data: Data) -> Data {
+        pending.append(contentsOf: data)
+        switch format {
+        case .hls:
+            var start = 0
+            for (index, byte) in pending.enumerated() where byte == 0x0a {
+                hlsLine(String(bytes: pending[start..<index], encoding: .utf8) ?? "")
+                start = index + 1
+            }
+            pending.removeFirst(start)
+        case .dash:
+            scanDASH()
+        }
+        return takeOutput()
+    }
+
+    func finish() -> Data {
+        switch format {
+        case .hls:
+            if !pending.isEmpty {
+                hlsLine(String(bytes: pending, encoding: .utf8) ?? "")
+                pending = []
+            }
+            for variant in chosen(variants, reorder: true) {
+                variant.parts.forEach(emit)
+            }
+            isLive = !sawEndList && variants.isEmpty
+        case .dash:
+            scanDASH()
+            if !pending.isEmpty {
+                dashToken(String(bytes: pending, encoding: .utf8) ?? "", isTag: false)
+                pending = []
+            }
+        }
+        return takeOutput()
+    }
+
+    private func emit(_ text: String) {
+        output.append(text.data(using: .utf8) ?? Data())
+        if format == .hls {
+            output.append(0x0a)
+        }
+    }
+
+    private func takeOutput() -> Data {
+        defer {
+            output = Data()
+        }
+        return output
+    }
+
+    //MARK: HLS
+    private func hlsLine(_ raw: String) {
+        let line = raw.trimmingCharacters(in: .whitespacesAndNewlines)
+        if line.hasPrefix("#EXT-X-STREAM-INF:") {
+            variantTags = [line]
+            return
+        }
+        if line.hasPrefix("#") || line.isEmpty {
+            if line.hasPrefix("#EXTINF:") {
+                expectingSegment = true
+            } else if line.hasPrefix("#EXT-X-ENDLIST") {
+                sawEndList = true
+            }
+            let rewritten = rewritingURIAttribute(line)
+            if variantTags != nil {
+                variantTags?.append(rewritten)
+            } else {
+                emit(rewritten)
+            }
+            return
+        }
+
+        if let tags = variantTags {
+            // Held until the end, when the set is known and can be pruned.
+            let attributes = HLSPlaylist.attributes(of: tags[0])
+            let resolution = (attributes["RESOLUTION"] ?? "").components(separatedBy: "x").flatMap { Int($0) }
+            variants.append(Variant(id: variants.count,
+                                    parts: tags + [proxied(line)],
+                                    bandwidth: Int(attributes["BANDWIDTH"] ?? "") ?? 0,
+                                    width: resolution.count == 2 ? resolution[0] : 0,
+                                    height: resolution.count == 2 ? resolution[1] : 0))
+            variantTags = nil
+            return
+        }
+        if expectingSegment, let url = URL(string: line, relativeTo: baseURL)?.absoluteURL {
+            segments.append(url)
+        }
+        expectingSegment = false
+        emit(proxied(line))
+    }
+
+    private func rewritingURIAttribute(_ line: String) -> String {
+        guard let start = line.range(of: "URI=\""), let end = line.range(of: "\"", range: start.upperBound..<line.endIndex) else {
+            return line
+        }
+        return line.substring(to: start.upperBound) + proxied(line.substring(with: start.upperBound..<end.lowerBound)) + line.substring(from: end.lowerBound)
+    }
+
+    //MARK: DASH
+
+    /// Splits what has arrived into tags and the text between them. Text is
+    /// held until the tag after it begins, so entities are never cut in two.
+    private func scanDASH() {
+        var start = 0
+        var index = scanned
+        while index < pending.count {
+            let byte = pending[index]
+            if inTag {
+                if let quote = tagQuote {
+                    if byte == quote {
+                        tagQuote = nil
+                    }
+                } else if byte == 0x22 || byte == 0x27 {
+                    tagQuote = byte
+                } else if byte == 0x3e {
+                    inTag = false
+                    dashToken(String(bytes: pending[start...index], encoding: .utf8) ?? "", isTag: true)
+                    start = index + 1
+                }
+            } else if byte == 0x3c {
+                if index > start {
+                    dashToken(String(bytes: pending[start..<index], encoding: .utf8) ?? "", isTag: false)
+                }
+                inTag = true
+                start = index
+            }
+            index += 1
+        }
+        pending.removeFirst(start)
+        scanned = pending.count
+    }
+
+    private func dashToken(_ token: String, isTag: Bool) {
+        guard isTag else {
+            if inBaseURL {
+                let link = ManifestRewriter.unescaped(token.trimmingCharacters(in: .whitespacesAndNewlines))
+                if let url = URL(string: link, relativeTo: dashBase)?.absoluteURL {
+                    bases.append((depth - 1, url))
+                }
+                emitDASH(ManifestRewriter.escaped(proxied(link, against: dashBase)))
+            } else {
+                emitDASH(token)
+            }
+            return
+        }
+        let name = ManifestRewriter.tagName(token)
+        let attributes = ManifestRewriter.attributes(ofTag: token)
+        let selfClosing = token.hasSuffix("/>")
+        if name.hasPrefix("/") {
+            depth -= 1
+            bases = bases.filter { $0.depth <= depth }
+        } else if !selfClosing && !name.hasPrefix("?") && !name.hasPrefix("!") {
+            depth += 1
+        }
+        switch name {
+        case "MPD":
+            isLive = attributes["type"] == "dynamic"
+        case "BaseURL":
+            inBaseURL = !selfClosing
+        case "/BaseURL":
+            inBaseURL = false
+        case "AdaptationSet" where !selfClosing:
+            adaptationSet = []
+        case "Representation" where adaptationSet != nil:
+            representation = Variant(id: variants.count, parts: [], bandwidth: Int(attributes["bandwidth"] ?? "") ?? 0, width: Int(attributes["width"] ?? "") ?? 0, height: Int(attributes["height"] ?? "") ?? 0)
+        default:
+            break
+        }
+
+        emitDASH(rewritingAttributes(token))
+
+        if (name == "/Representation" || (name == "Representation" && selfClosing)), let finished = representation {
+            representation = nil
+            adaptationSet?.append(.variant(finished.id))
+            variants.append(finished)
+        } else if name == "/AdaptationSet", let parts = adaptationSet {
+            adaptationSet = nil
+            // Audio and text carry no size; only video is pruned.
+            let video = variants.filter { $0.width > 0 }
+            let kept = chosen(video, reorder: false)
+            for part in parts {
+                switch part {
+                case .text(let text):
+                    output.append(text.data(using: .utf8) ?? Data())
+                case .variant(let index):
+                    let variant = variants[index]
+                    if variant.width == 0 || kept.contains(where: { $0.id == variant.id }) {
+                        output.append(variant.parts.joined().data(using: .utf8) ?? Data())
+                    }
+                }
+            }
+            variants = []
+        }
+    }
+
+    /// What relative DASH links resolve against: the innermost `BaseURL`, or the manifest.
+    private var dashBase: URL {
+        return bases.last?.url ?? baseURL
+    }
+
+    private func emitDASH(_ text: String) {
+        if representation != nil {
+            representation?.parts.append(text)
+        } else if adaptationSet != nil {
+            adaptationSet?.append(.text(text))
+        } else {
+            output.append(text.data(using: .utf8) ?? Data())
+        }
+    }
+
+    private func rewritingAttributes(_ tag: String) -> String {
+        var rewritten = tag
+        for name in ["media", "initialization", "sourceURL", "index"] {
+            for quote in ["\"", "'"] {
+                guard let start = rewritten.range(of: name + "=" + quote), start.lowerBound > rewritten.startIndex,
+                    " \t\r\n".characters.contains(rewritten.characters[rewritten.index(before: start.lowerBound)]),
+                    let end = rewritten.range(of: quote, range: start.upperBound..<rewritten.endIndex) else {
+                    continue
+                }
+                let value = ManifestRewriter.unescaped(rewritten.substring(with: start.upperBound..<end.lowerBound))
+                rewritten.replaceSubrange(start.upperBound..<end.lowerBound, with: ManifestRewriter.escaped(proxied(value, against: dashBase)))
+            }
+        }
+        return rewritten
+    }
+
+    /// `Name` or `/Name`, without any namespace prefix.
+    private static func tagName(_ tag: String) -> String {
+        var name = ""
+        for character in tag.characters.dropFirst() {
+            if " \t\r\n>".characters.contains(character) || (character == "/" && !name.isEmpty) {
+                break
+            }
+            name.append(character)
+        }
+        let closing = name.hasPrefix("/")
+        let local = (closing ? String(name.characters.dropFirst()) : name).components(separatedBy: ":").last ?? ""
+        return (closing ? "/" : "") + local
+    }
+
+    private static func attributes(ofTag tag: String) -> [String: String] {
+        var attributes: [String: String] = [:]
+        var rest = tag
+        while let equals = rest.range(of: "=") {
+            let name = rest.substring(to: equals.lowerBound).components(separatedBy: .whitespacesAndNewlines).last ?? ""
+            let afterEquals = rest.substring(from: equals.upperBound)
+            guard let quote = afterEquals.characters.first, quote == "\"" || quote == "'" else {
+                break
+            }
+            let valueStart = afterEquals.index(after: afterEquals.startIndex)
+            guard let close = afterEquals.range(of: String(quote), range: valueStart..<afterEquals.endIndex) else {
+                break
+            }
+            attributes[name] = afterEquals.substring(with: valueStart..<close.lowerBound)
+            rest = afterEquals.substring(from: close.upperBound)
+        }
+        return attributes
+    }
+
+    private static func unescaped(_ text: String) -> String {
+        return text.replacingOccurrences(of: "&amp;", with: "&")
+    }
+
+    private static func escaped(_ text: String) -> String {
+        return text.replacingOccurrences(of: "&", with: "&amp;")
+    }
+
+    //MARK: Links
+
+    /// Any link, absolute or relative, made a proxied path. Relative ones are
+    /// resolved against `base` first, since a root-relative or `../` link
+    /// would otherwise leave the proxied directory. DASH templates keep their
+    /// `$…$` fields outside the encoded target, where the receiver can fill
+    /// them in. Links that are not HTTP, such as key URIs, pass through.
+    private func proxied(_ uri: String, against base: URL? = nil) -> String {
+        let base = base ?? baseURL
+        guard !uri.isEmpty else {
+            return uri
+        }
+        if let field = uri.range(of: "$") {
+            let slash = uri.range(of: "/", options: .backwards, range: uri.startIndex..<field.lowerBound)
+            let directory = slash.map { uri.substring(to: $0.upperBound) } ?? "./"
+            guard let url = URL(string: directory, relativeTo: base)?.absoluteURL, ManifestRewriter.isHTTP(url) else {
+                return uri
+            }
+            return MediaProxy.directoryPath(for: url, referer: referer) + (slash.map { uri.substring(from: $0.upperBound) } ?? uri)
+        }
+        guard let url = URL(string: uri, relativeTo: base)?.absoluteURL, ManifestRewriter.isHTTP(url) else {
+            return uri
+        }
+        return uri.hasSuffix("/") ? MediaProxy.directoryPath(for: url, referer: referer) : MediaProxy.path(for: url, referer: referer)
+    }
+
+    private static func isHTTP(_ url: URL) -> Bool {
+        let scheme = url.scheme?.lowercased()
+        return scheme == "http" || scheme == "https"
+    }
+
+    //MARK: Variants
+
+    /// The variants within the limits, or the smallest if none are. With
+    /// `reorder`, the one to start on goes first: the best that needs at most
+    /// half the measured bandwidth, or the first at 480p or above when
+    /// nothing has been measured yet.
+    private func chosen(_ all: [Variant], reorder: Bool) -> [Variant] {
+        guard !all.isEmpty else {
+            return []
+        }
+        var kept = all.filter { variant in
+            let fitsScreen = variant.width == 0 || (variant.width <= limits.width && variant.height <= limits.height)
+            let fitsLink = limits.bandwidth == 0 || variant.bandwidth == 0 || variant.bandwidth <= limits.bandwidth
+            return fitsScreen && fitsLink
+        }
+        if kept.isEmpty, let smallest = all.min(by: { $0.bandwidth < $1.bandwidth }) {
+            kept = [smallest]
+        }
+        variantsDropped += all.count - kept.count
+        guard reorder else {
+            return kept
+        }
+
+        let byBandwidth = kept.enumerated().sorted { $0.element.bandwidth < $1.element.bandwidth }
+        var start: Int?
+        if limits.measuredBandwidth > 0 {
+            start = byBandwidth.filter { $0.element.bandwidth <= limits.measuredBandwidth / 2 }.last?.offset
+        } else {
+            start = byBandwidth.first { $0.element.height >= 480 }?.offset
+        }
+        let first = start ?? byBandwidth[0].offset
+        return [kept[first]] + kept.enumerated().filter { $0.offset != first }.map { $0.element }
+    }
+}
@@ -0,0 +1,254 @@
+//
+//  ManualDeviceProvider.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+import GoogleCast
+
+/// Connects a TCP socket with a deadline, for probing receivers.
+enum TCPProbe {
+
+    /// Seconds the connection took, or nil if it failed or timed out.
+    /// Blocks the calling thread; call it off the main thread.
+    static func connect(host: String, port: UInt16, timeout: TimeInterval) -> TimeInterval? {
+        var address = sockaddr_in()
+        address.sin_len = UInt8(MemoryLayout<sockaddr_in>.size)
+        address.sin_family = sa_family_t(AF_INET)
+        address.sin_port = port.bigEndian
+        guard inet_pton(AF_INET, host, &address.sin_addr) == 1 else {
+            return nil
+        }
+        let socketFD = socket(AF_INET, SOCK_STREAM, 0)
+        guard socketFD >= 0 else {
+            return nil
+        }
+        defer {
+            Darwin.close(socketFD)
+        }
+        var yes: Int32 = 1
+        setsockopt(socketFD, SOL_SOCKET, SO_NOSIGPIPE, &yes, socklen_t(MemoryLayout<Int32>.size))
+        _ = fcntl(socketFD, F_SETFL, fcntl(socketFD, F_GETFL, 0) | O_NONBLOCK)
+
+        let started = CACurrentMediaTime()
+        let result = withUnsafePointer(to: &address) {
+            $0.withMemoryRebound(to: sockaddr.self, capacity: 1) {
+                Darwin.connect(socketFD, $0, socklen_t(MemoryLayout<sockaddr_in>.size))
+            }
+        }
+        if result != 0 && errno != EINPROGRESS {
+            return nil
+        }
+        if result != 0 {
+            var descriptor = pollfd(fd: socketFD, events: Int16(POLLOUT), revents: 0)
+            guard poll(&descriptor, 1, Int32(timeout * 1000)) == 1 else {
+                return nil
+            }
+            var error: Int32 = 0
+            var length = socklen_t(MemoryLayout<Int32>.size)
+            guard getsockopt(socketFD, SOL_SOCKET, SO_ERROR, &error, &length) == 0, error == 0 else {
+                return nil
+            }
+        }
+        return CACurrentMediaTime() - started
+    }
+
+    /// The first IPv4 address `host` resolves to; an address stays as it is.
+    /// Blocks the calling thread; call it off the main thread.
+    static func resolve(_ host: String) -> String? {
+        var hints = addrinfo()
+        hints.ai_family = AF_INET
+        hints.ai_socktype = SOCK_STREAM
+        var results: UnsafeMutablePointer<addrinfo>?
+        guard getaddrinfo(host, nil, &hints, &results) == 0, let first = results else {
+            return nil
+        }
+        defer {
+            freeaddrinfo(results)
+        }
+        guard var address = first.pointee.ai_addr?.withMemoryRebound(to: sockaddr_in.self, capacity: 1, { $0.pointee.sin_addr }) else {
+            return nil
+        }
+        var buffer = [CChar](repeating: 0, count: Int(INET_ADDRSTRLEN))
+        guard inet_ntop(AF_INET, &address, &buffer, socklen_t(buffer.count)) != nil else {
+            return nil
+        }
+        return String(cString: buffer)
+    }
+}
+
+/// Publishes receivers from a list of addresses, for networks that filter
+/// the multicast mDNS relies on.
+///
+/// Each `host` or `host:port` entry, a name or an IPv4 address, is resolved
+/// and probed with a short TCP connect to the Cast port, all at once, and the
+/// receiver's `eureka_info` on port 8008 supplies its name and model.
+/// Published devices are then kept fresh with a plain connect every
+/// `livenessInterval`, and unpublished after `allowedMisses` in a row; the
+/// entries not published are probed again on the same timer, so a TV that
+/// was off turns up once it is on. Main thread only, apart from the probes.
+final class ManualDeviceProvider: GCKDeviceProvider {
+
+    static let shared = ManualDeviceProvider()
+    static let deviceCategory = "com.fadybasem.cast.manual"
+    private static let defaultsKey = "ManualDeviceAddresses"
+
+    private struct Known {
+        let device: GCKDevice
+        var misses: Int
+    }
+
+    //MARK: Properties
+    var probeTimeout: TimeInterval = 1.5
+    var livenessInterval: TimeInterval = 30
+    var allowedMisses = 2
+    /// The options sessions are created with; set to those the context was given.
+    var castOptions = GCKCastOptions(receiverApplicationID: kGCKMediaDefaultReceiverApplicationID)
+
+    private var known: [String: Known] = [:]
+    /// Entries with a probe under way.
+    private var probing = Set<String>()
+    private var timer: Timer?
+    private let probeQueue = DispatchQueue(label: "ManualDeviceProvider", attributes: .concurrent)
+
+    /// `host` or `host:port` entries, saved across launches.
+    var addresses: [String] {
+        get {
+            return UserDefaults.standard.stringArray(forKey: ManualDeviceProvider.defaultsKey) ?? []
+        }
+        set {
+            UserDefaults.standard.set(newValue, forKey: ManualDeviceProvider.defaultsKey)
+            if timer != nil {
+                refresh()
+            }
+        }
+    }
+
+    //MARK: Lifecycle
+    override init() {
+        super.init(deviceCategory: ManualDeviceProvider.deviceCategory)
+    }
+
+    override func startDiscovery() {
+        notifyDidStartDiscovery()
+        timer?.invalidate()
+        timer = Timer.scheduledTimer(timeInterval: livenessInterval, target: self, selector: #selector(checkLiveness), userInfo: nil, repeats: true)
+        refresh()
+    }
+
+    override func stopDiscovery() {
+        timer?.invalidate()
+        timer = nil
+    }
+
+    override func createSession(for device: GCKDevice, sessionID: String?) -> GCKSession {
+        return GCKCastSession(device: device, sessionID: sessionID, castOptions: castOptions)
+    }
+
+    //MARK: Probing
+
+    /// Probes every configured address and publishes the ones that answer.
+    func refresh() {
+        let endpoints = addresses.flatMap { ManualDeviceProvider.endpoint(of: $0) }
+        for (key, entry) in known where !endpoints.contains(where: { ManualDeviceProvider.key($0.host, $0.port) == key }) {
+            known.removeValue(forKey: key)
+            notifyDidUnpublish(entry.device)
+        }
+        for endpoint in endpoints where known[ManualDeviceProvider.key(endpoint.host, endpoint.port)] == nil {
+            probe(host: endpoint.host, port: endpoint.port)
+        }
+    }
+
+    private func probe(host: String, port: UInt16) {
+        let key = ManualDeviceProvider.key(host, port)
+        guard !probing.contains(key) else {
+            return
+        }
+        probing.insert(key)
+        let timeout = probeTimeout
+        probeQueue.async {
+            guard let address = TCPProbe.resolve(host), TCPProbe.connect(host: address, port: port, timeout: timeout) != nil else {
+                DispatchQueue.main.async {
+                    self.probing.remove(key)
+                }
+                return
+            }
+            ManualDeviceProvider.information(host: address, timeout: timeout) { info in
+                DispatchQueue.main.async {
+                    self.probing.remove(key)
+                    self.publish(host: host, address: address, port: port, info: info)
+                }
+            }
+        }
+    }
+
+    /// `host` as configured, `address` what it resolved to.
+    private func publish(host: String, address: String, port: UInt16, info: [String: Any]) {
+        let key = ManualDeviceProvider.key(host, port)
+        guard known[key] == nil, addresses.contains(where: { ManualDeviceProvider.endpoint(of: $0).map { ManualDeviceProvider.key($0.host, $0.port) } == key }) else {
+            return
+        }
+        let deviceInfo = info["device_info"] as? [String: Any]
+        let udn = (info["ssdp_udn"] as? String)?.replacingOccurrences(of: "-", with: "")
+        let device = createDevice(withID: udn ?? key, ipAddress: address, servicePort: port)
+        device.friendlyName = info["name"] as? String ?? host
+        device.modelName = deviceInfo?["model_name"] as? String
+        device.manufacturer = deviceInfo?["manufacturer"] as? String
+        known[key] = Known(device: device, misses: 0)
+        notifyDidPublish(device)
+    }
+
+    /// A bare connect to each published device, no HTTP and no mDNS, and a
+    /// fresh probe of each entry that is not published.
+    func checkLiveness() {
+        refresh()
+        let timeout = probeTimeout
+        for (key, entry) in known {
+            let device = entry.device
+            probeQueue.async {
+                let alive = TCPProbe.connect(host: device.ipAddress, port: device.servicePort, timeout: timeout) != nil
+                DispatchQueue.main.async {
+                    guard var current = self.known[key] else {
+                        return
+                    }
+                    current.misses = alive ? 0 : current.misses + 1
+                    if current.misses > self.allowedMisses {
+                        self.known.removeValue(forKey: key)
+                        self.notifyDidUnpublish(device)
+                    } else {
+                        self.known[key] = current
+                    }
+                }
+            }
+        }
+    }
+
+    //MARK: Helpers
+    private static func endpoint(of address: String) -> (host: String, port: UInt16)? {
+        let parts = address.trimmingCharacters(in: .whitespaces).components(separatedBy: ":")
+        guard let host = parts.first, !host.isEmpty, parts.count <= 2 else {
+            return nil
+        }
+        let port = parts.count == 2 ? UInt16(parts[1]) : 8009
+        return port.map { (host, $0) }
+    }
+
+    private static func key(_ host: String, _ port: UInt16) -> String {
+        return "\(host):\(port)"
+    }
+
+    /// The receiver's own description of itself; empty if it does not answer.
+    private static func information(host: String, timeout: TimeInterval, completion: @escaping ([String: Any]) -> Void) {
+        guard let url = URL(string: "http://\(host):8008/setup/eureka_info?params=name,device_info,ssdp_udn") else {
+            completion([:])
+            return
+        }
+        URLSession.shared.dataTask(with: URLRequest(url: url, cachePolicy: .reloadIgnoringLocalCacheData, timeoutInterval: timeout)) { data, _, _ in
+            completion(data.flatMap { (try? JSONSerialization.jsonObject(with: $0)) as? [String: Any] } ?? [:])
+        }.resume()
+    }
+}
@@ -0,0 +1,123 @@
+//
+//  MediaInformationCache.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import AVFoundation
+import GoogleCast
+
+/// Builds the `GCKMediaInformation` for every library item as soon as it is
+/// discovered, so a tap only has to look it up. Durations are resolved with
+/// AVFoundation off the main thread; the cache itself is main thread only.
+final class MediaInformationCache {
+
+    static let shared = MediaInformationCache()
+
+    //MARK: Properties
+    private var informations: [Int: GCKMediaInformation] = [:]
+    private var pending = Set<Int>()
+    private var contentTypes: [Int: String] = [:]
+    private var probing = Set<Int>()
+
+    //MARK: Methods
+
+    /// Starts resolving `item` unless it is already cached or in flight.
+    func prepare(_ item: MediaItem) {
+        if informations[item.id] != nil || pending.contains(item.id) {
+            return
+        }
+        guard let url = URL(string: item.url) else {
+            return
+        }
+        pending.insert(item.id)
+
+        let asset = AVURLAsset(url: url)
+        asset.loadValuesAsynchronously(forKeys: ["duration"]) {
+            var error: NSError?
+            let duration = asset.statusOfValue(forKey: "duration", error: &error) == .loaded ? asset.duration.seconds : 0
+            DispatchQueue.main.async {
+                self.pending.remove(item.id)
+                self.informations[item.id] = MediaInformationCache.makeInformation(for: item, duration: duration.isFinite ? duration : 0, contentType: self.contentTypes[item.id])
+            }
+        }
+    }
+
+    /// Asks the server for the real MIME type of `item` with a HEAD request.
+    /// Links without a recognisable extension otherwise go out without one.
+    func resolveContentType(_ item: MediaItem) {
+        if contentTypes[item.id] != nil || probing.contains(item.id) {
+            return
+        }
+        guard let url = URL(string: item.url) else {
+            return
+        }
+        probing.insert(item.id)
+
+        var request = MediaProxy.shared.request(for: url, referer: item.pageURL)
+        request.cachePolicy = .reloadIgnoringLocalCacheData
+        request.timeoutInterval = 5
+        request.httpMethod = "HEAD"
+        URLSession.shared.dataTask(with: request) { _, response, _ in
+            DispatchQueue.main.async {
+                self.probing.remove(item.id)
+                guard let mimeType = response?.mimeType, MediaInformationCache.isMediaType(mimeType) else {
+                    return
+                }
+                self.contentTypes[item.id] = mimeType
+                if let duration = self.informations[item.id]?.streamDuration {
+                    self.informations[item.id] = MediaInformationCache.makeInformation(for: item, duration: duration, contentType: mimeType)
+                }
+            }
+        }.resume()
+    }
+
+    /// Whether `item` has both its duration and a server-confirmed MIME type.
+    func isResolved(_ item: MediaItem) -> Bool {
+        return informations[item.id] != nil && contentTypes[item.id] != nil
+    }
+
+    /// The prepared information, or one without a duration if AVFoundation
+    /// has not answered yet. The receiver reports the real duration either way.
+    func information(for item: MediaItem) -> GCKMediaInformation {
+        if let information = informations[item.id] {
+            // Whether the item goes through the proxy, and its subtitles, can change after it was built.
+            if information.contentID != MediaProxy.shared.castURL(for: item) || information.mediaTracks?.count ?? 0 != MediaLibrary.shared.subtitles(for: item).count {
+                informations[item.id] = MediaInformationCache.makeInformation(for: item, duration: information.streamDuration, contentType: contentTypes[item.id])
+            }
+            return informations[item.id]!
+        }
+        return MediaInformationCache.makeInformation(for: item, duration: 0, contentType: contentTypes[item.id])
+    }
+
+    //MARK: Helpers
+    private static func makeInformation(for item: MediaItem, duration: TimeInterval, contentType: String?) -> GCKMediaInformation {
+        let metadata = GCKMediaMetadata(metadataType: .generic)
+        metadata.setString(item.title.isEmpty ? item.url : item.title, forKey: kGCKMetadataKeyTitle)
+        if !item.pageTitle.isEmpty {
+            metadata.setString(item.pageTitle, forKey: kGCKMetadataKeySubtitle)
+        }
+        let castType = MediaProxy.shared.remuxes(item) ? "video/mp4" : contentType ?? item.contentType
+        return GCKMediaInformation(contentID: MediaProxy.shared.castURL(for: item), streamType: .unknown, contentType: castType, metadata: metadata, streamDuration: duration, mediaTracks: subtitleTracks(for: item), textTrackStyle: nil, customData: nil)
+    }
+
+    /// The page's subtitles as text tracks, numbered from 1 in the order they were found.
+    private static func subtitleTracks(for item: MediaItem) -> [GCKMediaTrack]? {
+        let pageURL = item.pageURL
+        let tracks = MediaLibrary.shared.subtitles(for: item).enumerated().flatMap { (index, subtitle) -> GCKMediaTrack? in
+            guard let url = MediaProxy.shared.castURL(for: subtitle, pageURL: pageURL) else {
+                return nil
+            }
+            return GCKMediaTrack(identifier: index + 1, contentIdentifier: url, contentType: "text/vtt", type: .text, textSubtype: .subtitles, name: subtitle.label.isEmpty ? nil : subtitle.label, languageCode: subtitle.language.isEmpty ? nil : subtitle.language, customData: nil)
+        }
+        return tracks.isEmpty ? nil : tracks
+    }
+
+    private static func isMediaType(_ mimeType: String) -> Bool {
+        let lowercased = mimeType.lowercased()
+        return lowercased.hasPrefix("video/") || lowercased.hasPrefix("audio/") || lowercased.contains("mpegurl") || lowercased.contains("dash+xml")
+    }
+}
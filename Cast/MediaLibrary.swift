@@ -0,0 +1,125 @@
+//
+//  MediaLibrary.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+struct MediaItem {
+    let id: Int
+    let url: String
+    let title: String
+    let fileName: String
+    let pageTitle: String
+    /// The page the link was found on; empty for media that is not from the web.
+    let pageURL: String
+    let contentType: String
+}
+
+/// A subtitle file linked from the page a video was found on.
+struct SubtitleTrack {
+    let url: String
+    /// BCP 47 code from the page, empty when it did not say.
+    let language: String
+    let label: String
+}
+
+/// Every video link discovered while browsing, in discovery order, together
+/// with the search index over it. Main thread only.
+final class MediaLibrary {
+
+    static let shared = MediaLibrary()
+    static let didChangeNotification = Notification.Name("MediaLibraryDidChange")
+
+    //MARK: Properties
+    private(set) var items: [MediaItem] = []
+    private var idsByURL: [String: Int] = [:]
+    private var subtitlesByPage: [String: [SubtitleTrack]] = [:]
+    private let index = MediaSearchIndex()
+
+    //MARK: Methods
+
+    /// Adds a discovered link unless it is already known and returns its item.
+    @discardableResult
+    func add(url: String, pageTitle: String, pageURL: String = "") -> MediaItem? {
+        if url.isEmpty {
+            return nil
+        }
+        if let id = idsByURL[url] {
+            return items[id]
+        }
+
+        let fileName = MediaLibrary.fileName(of: url)
+        let contentType = MediaLibrary.contentType(forPathExtension: NSString(string: fileName).pathExtension)
+        let item = MediaItem(id: items.count, url: url, title: MediaLibrary.title(fromFileName: fileName), fileName: fileName, pageTitle: pageTitle, pageURL: pageURL, contentType: contentType)
+        items.append(item)
+        idsByURL[url] = item.id
+        index.add(documentID: item.id, fields: [(.title, item.title), (.fileName, item.fileName), (.pageTitle, item.pageTitle)])
+        MediaInformationCache.shared.prepare(item)
+        MediaProxy.shared.probe(item)
+
+        NotificationCenter.default.post(name: MediaLibrary.didChangeNotification, object: self)
+        return item
+    }
+
+    /// Remembers subtitles found on a page; every video from that page offers them.
+    func addSubtitles(_ tracks: [SubtitleTrack], pageURL: String) {
+        var known = subtitlesByPage.removeValue(forKey: pageURL) ?? []
+        for track in tracks where !known.contains(where: { $0.url == track.url }) {
+            known.append(track)
+        }
+        subtitlesByPage[pageURL] = known
+    }
+
+    /// Subtitles for `item`, in the order found, so their positions stay valid as track IDs.
+    func subtitles(for item: MediaItem) -> [SubtitleTrack] {
+        return item.pageURL.isEmpty ? [] : subtitlesByPage[item.pageURL] ?? []
+    }
+
+    /// Ranked matches for `query`, or every item when the query is blank.
+    func search(_ query: String) -> [MediaItem] {
+        if query.trimmingCharacters(in: .whitespaces).isEmpty {
+            return items
+        }
+        return index.search(query).map { items[$0] }
+    }
+
+    //MARK: Helpers
+    private static func fileName(of url: String) -> String {
+        let path = URL(string: url)?.path ?? url
+        let name = NSString(string: path).lastPathComponent
+        return name.removingPercentEncoding ?? name
+    }
+
+    static func contentType(forPathExtension pathExtension: String) -> String {
+        switch pathExtension.lowercased(){
+        case "flv":
+            return "video/x-flv"
+        case "mp4":
+            return "video/mp4"
+        case "m3u8":
+            return "application/x-mpegURL"
+        case "ts":
+            return "video/MP2T"
+        case "3gp":
+            return "video/3gpp"
+        case "mov":
+            return "video/quicktime"
+        case "avi":
+            return "video/x-msvideo"
+        case "wmv":
+            return "video/x-ms-wmv"
+        default:
+            return ""
+        }
+    }
+
+    /// "big_buck-bunny.mp4" becomes "big buck bunny".
+    private static func title(fromFileName fileName: String) -> String {
+        let stem = NSString(string: fileName).deletingPathExtension
+        return stem.components(separatedBy: CharacterSet(charactersIn: "_-.+")).filter { !$0.isEmpty }.joined(separator: " ")
+    }
+}
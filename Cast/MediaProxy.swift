@@ -0,0 +1,687 @@
+//
+//  MediaProxy.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+import Security
+
+/// Relays media the receiver cannot fetch on its own.
+///
+/// Many hosts only serve a video to requests carrying the page's `Referer`,
+/// its cookies or a browser user agent. Such items are cast as
+/// `/proxy/<target>/<name>` on the local media server, and the proxy fetches
+/// the original with those headers added. The target is encoded in the path
+/// itself, so proxied URLs stay valid across relaunches, and relative links
+/// inside playlists resolve against the original location. The encoded target
+/// is signed with a secret kept by this install, and anything unsigned is
+/// refused, so others on the network cannot have the proxy fetch for them.
+///
+/// Bodies are streamed through an `HTTPStream`, never held whole; when the
+/// receiver reads slower than the host sends, the upstream task is suspended.
+/// Range requests are forwarded and the host's answer relayed as is.
+/// Redirects are relayed too, pointing back through the proxy.
+///
+/// FLV, AVI and MPEG-TS, which the default receiver cannot play, are also
+/// cast through the proxy and remuxed to fragmented MP4 on the way.
+///
+/// HLS and DASH go through it too. Manifests are rewritten on the way by
+/// `ManifestRewriter`, and HLS segments are read ahead by `SegmentPrefetcher`.
+/// Subtitles found on pages are converted to WebVTT by `SubtitleConverter`.
+final class MediaProxy: NSObject, URLSessionDataDelegate {
+
+    static let shared = MediaProxy()
+    static let prefix = "/proxy/"
+    private static let secretKey = "MediaProxySecret"
+    /// Bytes of the HMAC-SHA256 kept in a token.
+    private static let signatureLength = 16
+
+    /// Random per install, so a token is only accepted by the phone that made it.
+    private static let secret: [UInt8] = {
+        if let saved = UserDefaults.standard.data(forKey: secretKey), saved.count == 32 {
+            return [UInt8](saved)
+        }
+        var bytes = [UInt8](repeating: 0, count: 32)
+        _ = SecRandomCopyBytes(kSecRandomDefault, bytes.count, &bytes)
+        UserDefaults.standard.set(Data(bytes: bytes), forKey: secretKey)
+        return bytes
+    }()
+
+    private struct Target {
+        let url: URL
+        let referer: String
+        var remux = false
+        var subtitles = false
+
+        init(url: URL, referer: String, remux: Bool = false, subtitles: Bool = false) {
+            self.url = url
+            self.referer = referer
+            self.remux = remux
+            self.subtitles = subtitles
+        }
+    }
+
+    /// One upstream task and where its body goes.
+    private final class Relay {
+        let stream: HTTPStream
+        let remuxer: Remuxer?
+        var reportedStart = false
+        /// The upstream URL and page, for playlists and segments.
+        var url: URL?
+        var referer = ""
+        /// Set for a segment the prefetcher did not have, to time the miss.
+        var segmentRequestedAt: CFTimeInterval?
+        /// When a segment's first byte came and how many have followed, for the bandwidth estimate.
+        var transferStartedAt: CFTimeInterval?
+        var transferredBytes = 0
+        var rewriter: ManifestRewriter?
+        var rewriteTime: CFTimeInterval = 0
+        var converter: SubtitleConverter?
+
+        init(stream: HTTPStream, remuxer: Remuxer?) {
+            self.stream = stream
+            self.remuxer = remuxer
+        }
+    }
+
+    //MARK: Properties
+    /// Off, every item is cast with its original URL.
+    var isEnabled = true
+    /// Request headers passed on from the receiver.
+    private static let forwardedHeaders = ["range", "if-range", "accept"]
+    /// Response headers passed back from the host. The length is set separately.
+    private static let relayedHeaders = ["Content-Type", "Content-Range", "Accept-Ranges", "Last-Modified", "ETag"]
+
+    private let lock = NSLock()
+    private var storedUserAgent: String?
+    private var relays: [Int: Relay] = [:]
+    /// From the first source byte to the first MP4 fragment. Main thread only.
+    private(set) var remuxStartLatencies = LatencyHistogram()
+    /// Time spent rewriting each manifest, and variants it dropped. Main thread only.
+    private(set) var rewriteTimes = LatencyHistogram()
+    private(set) var variantsDropped = 0
+    /// Whether each probed URL plays without the page's headers. Main thread only.
+    private var directPlayable: [String: Bool] = [:]
+    private let delegateQueue: OperationQueue = {
+        let queue = OperationQueue()
+        queue.maxConcurrentOperationCount = 1
+        return queue
+    }()
+    private lazy var session: URLSession = {
+        let configuration = URLSessionConfiguration.default
+        // Cookies come from the shared storage `WebCookieBridge` copies the
+        // web view's into. Nothing is cached: the bodies are video and only
+        // pass through.
+        configuration.urlCache = nil
+        configuration.requestCachePolicy = .reloadIgnoringLocalCacheData
+        return URLSession(configuration: configuration, delegate: self, delegateQueue: self.delegateQueue)
+    }()
+
+    /// No cookies, no cache: what a receiver would send.
+    private let probeSession = URLSession(configuration: .ephemeral)
+
+    /// The browser's user agent, captured from the web view.
+    var userAgent: String? {
+        get {
+            lock.lock()
+            defer {
+                lock.unlock()
+            }
+            return storedUserAgent
+        }
+        set {
+            lock.lock()
+            storedUserAgent = newValue
+            lock.unlock()
+        }
+    }
+
+    //MARK: Lifecycle
+    func start() {
+        LocalMediaServer.shared.register(MediaProxy.prefix) { [weak self] request in
+            self?.handle(request) ?? .error(503)
+        }
+    }
+
+    //MARK: Cast URLs
+
+    /// The URL to hand the receiver for `item`: proxied when it has to be
+    /// remuxed, is an HLS or DASH manifest to rewrite, or came from a web page and has not
+    /// been shown to play without the page's headers.
+    func castURL(for item: MediaItem) -> String {
+        let remux = remuxes(item)
+        let manifest = ManifestRewriter.format(contentType: item.contentType, url: nil) != nil
+        guard isEnabled, remux || manifest || (!item.pageURL.isEmpty && directPlayable[item.url] != true),
+            let url = URL(string: item.url), let baseURL = LocalMediaServer.shared.baseURL else {
+            return item.url
+        }
+        return baseURL + MediaProxy.path(for: Target(url: url, referer: item.pageURL, remux: remux))
+    }
+
+    /// Whether `item` reaches the receiver as fragmented MP4 rather than as found.
+    func remuxes(_ item: MediaItem) -> Bool {
+        return isEnabled && Remuxer.canRemux(contentType: item.contentType)
+    }
+
+    /// The URL to hand the receiver for a subtitle track of a page: always
+    /// proxied, as it has to arrive as WebVTT with CORS headers.
+    func castURL(for track: SubtitleTrack, pageURL: String) -> String? {
+        guard let url = URL(string: track.url), let baseURL = LocalMediaServer.shared.baseURL else {
+            return nil
+        }
+        return baseURL + MediaProxy.path(for: Target(url: url, referer: pageURL, subtitles: true))
+    }
+
+    /// Fetches the first byte of `item` the way a receiver would, with no
+    /// cookies or referer, to learn whether it needs the proxy at all.
+    func probe(_ item: MediaItem) {
+        guard !item.pageURL.isEmpty, directPlayable[item.url] == nil, let url = URL(string: item.url) else {
+            return
+        }
+        var request = URLRequest(url: url, cachePolicy: .reloadIgnoringLocalCacheData, timeoutInterval: 5)
+        request.setValue("bytes=0-0", forHTTPHeaderField: "Range")
+        probeSession.dataTask(with: request) { _, response, error in
+            let status = (response as? HTTPURLResponse)?.statusCode ?? 0
+            DispatchQueue.main.async {
+                // Network failures say nothing about headers; leave those unknown.
+                if error == nil {
+                    self.directPlayable[item.url] = status > 0 && status < 400
+                }
+            }
+        }.resume()
+    }
+
+    /// A request for `url` carrying the headers of the page it was found on.
+    func request(for url: URL, referer: String) -> URLRequest {
+        var request = URLRequest(url: url)
+        if !referer.isEmpty {
+            request.setValue(referer, forHTTPHeaderField: "Referer")
+        }
+        if let userAgent = userAgent {
+            request.setValue(userAgent, forHTTPHeaderField: "User-Agent")
+        }
+        return request
+    }
+
+    //MARK: Paths
+
+    /// The proxied path for `url`, fetched with `referer`.
+    static func path(for url: URL, referer: String) -> String {
+        return path(for: Target(url: url, referer: referer))
+    }
+
+    /// A proxied path that names nothing itself: whatever is put after it
+    /// resolves inside `directory`.
+    static func directoryPath(for directory: URL, referer: String) -> String {
+        return prefix + token(for: Target(url: directory, referer: referer)) + "/"
+    }
+
+    /// `/proxy/<base64url of the target>/<name>`, where the name is the
+    /// target's own last component so relative links resolve beside it.
+    private static func path(for target: Target) -> String {
+        var path = prefix + token(for: target) + "/" + name(of: target.url)
+        if let query = target.url.query {
+            path += "?" + query
+        }
+        return path
+    }
+
+    /// `<base64url of the fields>.<base64url of their signature>`.
+    private static func token(for target: Target) -> String {
+        var fields = ["u": target.url.absoluteString, "r": target.referer]
+        if target.remux {
+            fields["m"] = "mp4"
+        } else if target.subtitles {
+            fields["m"] = "vtt"
+        }
+        let json = (try? JSONSerialization.data(withJSONObject: fields)) ?? Data()
+        return base64URL(json) + "." + base64URL(Data(bytes: signature(of: [UInt8](json))))
+    }
+
+    private static func signature(of message: [UInt8]) -> [UInt8] {
+        var digest = [UInt8](repeating: 0, count: Int(CC_SHA256_DIGEST_LENGTH))
+        CCHmac(CCHmacAlgorithm(kCCHmacAlgSHA256), secret, secret.count, message, message.count, &digest)
+        return Array(digest.prefix(signatureLength))
+    }
+
+    /// The fields of a token, if this install signed it.
+    private static func verifiedFields(of token: String) -> Data? {
+        let parts = token.components(separatedBy: ".")
+        guard parts.count == 2, let json = decodeBase64URL(parts[0]), let signed = decodeBase64URL(parts[1]) else {
+            return nil
+        }
+        let expected = signature(of: [UInt8](json))
+        let given = [UInt8](signed)
+        guard given.count == expected.count else {
+            return nil
+        }
+        // Compared in full whatever differs, so timing does not give the signature away.
+        var difference: UInt8 = 0
+        for (a, b) in zip(given, expected) {
+            difference |= a ^ b
+        }
+        return difference == 0 ? json : nil
+    }
+
+    private static func base64URL(_ data: Data) -> String {
+        return data.base64EncodedString()
+            .replacingOccurrences(of: "+", with: "-")
+            .replacingOccurrences(of: "/", with: "_")
+            .replacingOccurrences(of: "=", with: "")
+    }
+
+    private static func decodeBase64URL(_ string: String) -> Data? {
+        var base64 = string
+            .replacingOccurrences(of: "-", with: "+")
+            .replacingOccurrences(of: "_", with: "/")
+        base64 += String(repeating: "=", count: (4 - base64.characters.count % 4) % 4)
+        return Data(base64Encoded: base64)
+    }
+
+    private static func name(of url: URL) -> String {
+        let name = url.lastPathComponent.isEmpty || url.lastPathComponent == "/" ? "media" : url.lastPathComponent
+        return name.addingPercentEncoding(withAllowedCharacters: .urlPathAllowed) ?? "media"
+    }
+
+    /// The target and the upstream URL a proxied request stands for, or nil
+    /// unless its token was signed here.
+    private static func upstream(of request: HTTPRequest) -> (target: Target, url: URL)? {
+        let rest = request.path.substring(from: request.path.index(request.path.startIndex, offsetBy: prefix.characters.count))
+        guard let slash = rest.range(of: "/") else {
+            return nil
+        }
+        guard let json = verifiedFields(of: rest.substring(to: slash.lowerBound)),
+            let fields = (try? JSONSerialization.jsonObject(with: json)) as? [String: String],
+            let string = fields["u"], let url = URL(string: string) else {
+            return nil
+        }
+        let target = Target(url: url, referer: fields["r"] ?? "", remux: fields["m"] == "mp4", subtitles: fields["m"] == "vtt")
+
+        let relative = rest.substring(from: slash.upperBound)
+        let encoded = relative.addingPercentEncoding(withAllowedCharacters: .urlPathAllowed) ?? relative
+        if encoded == name(of: url) {
+            return (target, url)
+        }
+        // Only relative to the signed target: a path like `//other.host/` must not reach elsewhere.
+        guard let resolved = URL(string: encoded + (request.query.map { "?" + $0 } ?? ""), relativeTo: url)?.absoluteURL,
+            resolved.scheme == url.scheme, resolved.host == url.host, resolved.port == url.port else {
+            return nil
+        }
+        return (target, resolved)
+    }
+
+    //MARK: Relaying
+
+    /// Runs on the server's loop queue.
+    private func handle(_ request: HTTPRequest) -> HTTPResponse {
+        let receivedAt = CACurrentMediaTime()
+        guard let resolved = MediaProxy.upstream(of: request) else {
+            return .error(403)
+        }
+        let prefetcher = SegmentPrefetcher.shared
+        let isSegment = !resolved.target.remux && prefetcher.isSegment(resolved.url)
+        let stream = HTTPStream()
+        if isSegment, request.method == "GET" || request.method == "HEAD" {
+            let availability = prefetcher.cachedFile(for: resolved.url) { [weak self] file in
+                guard let file = file else {
+                    // The prefetch failed; the origin is asked after all.
+                    self?.relayFromOrigin(resolved, request: request, receivedAt: receivedAt, isSegment: true, into: stream)
+                    return
+                }
+                self?.relayPrefetched(file, of: resolved.url, request: request, receivedAt: receivedAt, into: stream)
+            }
+            switch availability {
+            case .cached(let file):
+                prefetcher.recordLatency(CACurrentMediaTime() - receivedAt, hit: true)
+                return HTTPResponse(status: 200, headers: [("Content-Type", MediaProxy.segmentContentType(of: resolved.url))], body: .file(file.path))
+            case .downloading:
+                return HTTPResponse(status: 200, body: .stream(stream))
+            case .missing:
+                break
+            }
+        }
+        relayFromOrigin(resolved, request: request, receivedAt: receivedAt, isSegment: isSegment, into: stream)
+        return HTTPResponse(status: 200, body: .stream(stream))
+    }
+
+    private static func segmentContentType(of url: URL) -> String {
+        let contentType = MediaLibrary.contentType(forPathExtension: url.pathExtension)
+        return contentType.isEmpty ? "application/octet-stream" : contentType
+    }
+
+    /// Fetches what `resolved` stands for from the origin into `stream`.
+    private func relayFromOrigin(_ resolved: (target: Target, url: URL), request: HTTPRequest, receivedAt: CFTimeInterval, isSegment: Bool, into stream: HTTPStream) {
+        var upstream = self.request(for: resolved.url, referer: resolved.target.referer)
+        // A remuxed stream has no byte ranges of its own; it always runs from the start.
+        let remuxer = resolved.target.remux ? Remuxer() : nil
+        let converter = resolved.target.subtitles ? SubtitleConverter(format: SubtitleConverter.format(of: resolved.url)) : nil
+        let transforms = remuxer != nil || converter != nil
+        upstream.httpMethod = transforms ? "GET" : request.method
+        for name in MediaProxy.forwardedHeaders where !transforms {
+            if let value = request.headers[name] {
+                upstream.setValue(value, forHTTPHeaderField: name)
+            }
+        }
+        // Keeps lengths and ranges meaning the same on both sides.
+        upstream.setValue("identity", forHTTPHeaderField: "Accept-Encoding")
+
+        let task = session.dataTask(with: upstream)
+        let delegateQueue = self.delegateQueue
+        // Resumed on the delegate queue, so it always follows the suspend that paused it.
+        stream.onSpaceAvailable = {
+            delegateQueue.addOperation {
+                task.resume()
+            }
+        }
+        stream.onCancel = {
+            task.cancel()
+        }
+        let relay = Relay(stream: stream, remuxer: remuxer)
+        relay.url = resolved.url
+        relay.referer = resolved.target.referer
+        relay.segmentRequestedAt = isSegment ? receivedAt : nil
+        relay.converter = converter
+        lock.lock()
+        relays[task.taskIdentifier] = relay
+        lock.unlock()
+        task.resume()
+    }
+
+    /// Answers a segment request that arrived while the prefetcher was still
+    /// downloading it from the finished download, honouring a byte range and
+    /// reading the file only as fast as the receiver takes it.
+    private func relayPrefetched(_ file: URL, of url: URL, request: HTTPRequest, receivedAt: CFTimeInterval, into stream: HTTPStream) {
+        guard let handle = try? FileHandle(forReadingFrom: file) else {
+            stream.respond(HTTPStream.Head(status: 502, headers: [], contentLength: 0))
+            stream.finish()
+            return
+        }
+        let total = off_t(handle.seekToEndOfFile())
+        var headers = [("Content-Type", MediaProxy.segmentContentType(of: url)), ("Accept-Ranges", "bytes")]
+        var status = 200
+        var start: off_t = 0
+        var remaining = total
+        if let rangeHeader = request.headers["range"] {
+            guard let range = HTTPServer.byteRange(rangeHeader, total: total) else {
+                handle.closeFile()
+                stream.respond(HTTPStream.Head(status: 416, headers: [("Content-Range", "bytes */\(total)")], contentLength: 0))
+                stream.finish()
+                return
+            }
+            status = 206
+            start = range.start
+            remaining = range.length
+            headers.append(("Content-Range", "bytes \(start)-\(start + remaining - 1)/\(total)"))
+        }
+        SegmentPrefetcher.shared.recordJoinLatency(CACurrentMediaTime() - receivedAt)
+        stream.respond(HTTPStream.Head(status: status, headers: headers, contentLength: Int64(remaining)))
+        guard request.method == "GET" else {
+            handle.closeFile()
+            stream.finish()
+            return
+        }
+        handle.seek(toFileOffset: UInt64(start))
+
+        // Everything below runs on the delegate queue, one step at a time.
+        var closed = false
+        func close() {
+            if !closed {
+                closed = true
+                handle.closeFile()
+            }
+        }
+        func pump() {
+            while !closed {
+                let chunk = remaining > 0 ? handle.readData(ofLength: Int(min(remaining, 256 << 10))) : Data()
+                if chunk.isEmpty {
+                    close()
+                    stream.finish(failed: remaining > 0)
+                    return
+                }
+                remaining -= off_t(chunk.count)
+                if !stream.write(chunk) {
+                    return
+                }
+            }
+        }
+        let delegateQueue = self.delegateQueue
+        stream.onSpaceAvailable = {
+            delegateQueue.addOperation {
+                pump()
+            }
+        }
+        stream.onCancel = {
+            delegateQueue.addOperation {
+                close()
+            }
+        }
+        delegateQueue.addOperation {
+            pump()
+        }
+    }
+
+    private func relay(for task: URLSessionTask) -> Relay? {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        return relays[task.taskIdentifier]
+    }
+
+    /// Sends remuxed output on, answering with the head first if this is the
+    /// first of it. Returns false when the stream wants the task paused.
+    private func forward(_ output: [UInt8], from relay: Relay) -> Bool {
+        guard let remuxer = relay.remuxer, !output.isEmpty else {
+            return true
+        }
+        if relay.stream.head == nil {
+            relay.stream.respond(HTTPStream.Head(status: 200, headers: [("Content-Type", "video/mp4")], contentLength: nil))
+        }
+        if !relay.reportedStart, let latency = remuxer.timeToFirstFragment {
+            relay.reportedStart = true
+            DispatchQueue.main.async {
+                self.remuxStartLatencies.record(latency)
+            }
+        }
+        return relay.stream.write(Data(bytes: output))
+    }
+
+    /// Sends the end of a rewritten manifest and hands an HLS media
+    /// playlist's segments to the prefetcher.
+    private func finishManifest(_ relay: Relay, _ rewriter: ManifestRewriter) {
+        let started = CACurrentMediaTime()
+        _ = relay.stream.write(rewriter.finish())
+        let rewriteTime = relay.rewriteTime + CACurrentMediaTime() - started
+        if rewriter.format == .hls, let url = relay.url, !rewriter.segments.isEmpty {
+            SegmentPrefetcher.shared.register(segments: rewriter.segments, isLive: rewriter.isLive, playlist: url, referer: relay.referer)
+        }
+        let dropped = rewriter.variantsDropped
+        DispatchQueue.main.async {
+            self.rewriteTimes.record(rewriteTime)
+            self.variantsDropped += dropped
+        }
+    }
+
+    /// Remux and manifest results so far.
+    func statistics() -> [String: Any] {
+        return ["remux_time_to_first_fragment": remuxStartLatencies.summary(),
+                "manifest_rewrite": rewriteTimes.summary(),
+                "variants_dropped": variantsDropped]
+    }
+
+    //MARK: URLSessionDataDelegate
+    func urlSession(_ session: URLSession, dataTask: URLSessionDataTask, didReceive response: URLResponse, completionHandler: @escaping (URLSession.ResponseDisposition) -> Void) {
+        guard let relay = relay(for: dataTask), let response = response as? HTTPURLResponse else {
+            completionHandler(.cancel)
+            return
+        }
+        let stream = relay.stream
+        if relay.remuxer != nil && response.statusCode < 300 {
+            // The head waits for the first output, so a source that cannot be remuxed still gets an error status.
+            completionHandler(.allow)
+            return
+        }
+        if relay.remuxer != nil {
+            // Errors pass through untouched.
+            lock.lock()
+            relays[dataTask.taskIdentifier] = Relay(stream: stream, remuxer: nil)
+            lock.unlock()
+        }
+        if relay.converter != nil && response.statusCode < 300 {
+            stream.respond(HTTPStream.Head(status: 200, headers: [("Content-Type", "text/vtt; charset=utf-8")], contentLength: nil))
+            completionHandler(.allow)
+            return
+        }
+        // Errors pass through untouched.
+        relay.converter = nil
+        var headers: [(String, String)] = []
+        for name in MediaProxy.relayedHeaders {
+            if let value = response.allHeaderFields[name] as? String {
+                headers.append((name, value))
+            }
+        }
+        // A body decoded on the way in no longer matches the host's length.
+        let encoded = response.allHeaderFields["Content-Encoding"] != nil
+        var length = encoded || response.expectedContentLength < 0 ? nil : Optional(response.expectedContentLength)
+        if response.statusCode == 200, let url = relay.url, let format = ManifestRewriter.format(contentType: response.mimeType ?? "", url: url) {
+            // Rewriting changes the length, so the manifest goes out without one.
+            relay.rewriter = ManifestRewriter(format: format, baseURL: url, referer: relay.referer, limits: VariantPolicy.shared.limits)
+            length = nil
+        }
+        stream.respond(HTTPStream.Head(status: response.statusCode, headers: headers, contentLength: length))
+        completionHandler(.allow)
+    }
+
+    func urlSession(_ session: URLSession, dataTask: URLSessionDataTask, didReceive data: Data) {
+        guard let relay = relay(for: dataTask) else {
+            return
+        }
+        if let requestedAt = relay.segmentRequestedAt {
+            relay.segmentRequestedAt = nil
+            relay.transferStartedAt = CACurrentMediaTime()
+            SegmentPrefetcher.shared.recordLatency(relay.transferStartedAt! - requestedAt, hit: false)
+        }
+        relay.transferredBytes += data.count
+        if let converter = relay.converter {
+            if !relay.stream.write(converter.append(data)) {
+                dataTask.suspend()
+            }
+            return
+        }
+        if let rewriter = relay.rewriter {
+            let started = CACurrentMediaTime()
+            let output = rewriter.append(data)
+            relay.rewriteTime += CACurrentMediaTime() - started
+            if !relay.stream.write(output) {
+                dataTask.suspend()
+            }
+            return
+        }
+        guard let remuxer = relay.remuxer else {
+            if !relay.stream.write(data) {
+                dataTask.suspend()
+            }
+            return
+        }
+        let output = remuxer.append(data)
+        if remuxer.failure != nil {
+            if relay.stream.head == nil {
+                relay.stream.respond(HTTPStream.Head(status: 415, headers: [], contentLength: 0))
+            }
+            relay.stream.finish(failed: relay.stream.head?.status == 200)
+            dataTask.cancel()
+            return
+        }
+        if !forward(output, from: relay) {
+            dataTask.suspend()
+        }
+    }
+
+    func urlSession(_ session: URLSession, task: URLSessionTask, willPerformHTTPRedirection response: HTTPURLResponse, newRequest request: URLRequest, completionHandler: @escaping (URLRequest?) -> Void) {
+        guard let relay = relay(for: task), let url = request.url else {
+            completionHandler(request)
+            return
+        }
+        if relay.remuxer != nil || relay.converter != nil {
+            // Remuxing and converting need the body here, so follow it rather than relay it.
+            completionHandler(request)
+            return
+        }
+        // Let the receiver follow it, through the proxy, so its later range
+        // requests go straight to the new location.
+        let referer = task.originalRequest?.value(forHTTPHeaderField: "Referer") ?? ""
+        let location = MediaProxy.path(for: Target(url: url, referer: referer))
+        relay.stream.respond(HTTPStream.Head(status: response.statusCode, headers: [("Location", location)], contentLength: 0))
+        relay.stream.finish()
+        completionHandler(nil)
+    }
+
+    func urlSession(_ session: URLSession, task: URLSessionTask, didCompleteWithError error: Error?) {
+        lock.lock()
+        let relay = relays.removeValue(forKey: task.taskIdentifier)
+        lock.unlock()
+        guard let finished = relay?.stream else {
+            return
+        }
+        if error == nil, let relay = relay, let remuxer = relay.remuxer {
+            _ = forward(remuxer.finish(), from: relay)
+        }
+        if error == nil, let relay = relay, let converter = relay.converter {
+            _ = relay.stream.write(converter.finish())
+        }
+        if error == nil, let relay = relay, let rewriter = relay.rewriter {
+            finishManifest(relay, rewriter)
+        }
+        if error == nil, let relay = relay, let started = relay.transferStartedAt {
+            let seconds = CACurrentMediaTime() - started
+            VariantPolicy.shared.recordTransfer(bytes: relay.transferredBytes, seconds: seconds)
+        }
+        if finished.head == nil {
+            finished.respond(HTTPStream.Head(status: error == nil ? 415 : 502, headers: [], contentLength: 0))
+            finished.finish()
+            return
+        }
+        finished.finish(failed: error != nil)
+    }
+
+    //MARK: Benchmark
+
+    /// Fetches the first `megabytes` of `item` directly and then through the
+    /// proxy over loopback, and reports both rates. Calls back on the main thread.
+    func measureThroughput(of item: MediaItem, megabytes: Int = 8, completion: @escaping ([String: Any]) -> Void) {
+        guard let url = URL(string: item.url), LocalMediaServer.shared.start() else {
+            completion([:])
+            return
+        }
+        start()
+        let proxied = URL(string: "http://127.0.0.1:\(LocalMediaServer.shared.port)" + MediaProxy.path(for: Target(url: url, referer: item.pageURL)))!
+        let range = "bytes=0-\((megabytes << 20) - 1)"
+        let configuration = URLSessionConfiguration.default
+        configuration.urlCache = nil
+        let session = URLSession(configuration: configuration)
+
+        func fetch(_ request: URLRequest, completion: @escaping ([String: Any]) -> Void) {
+            var request = request
+            request.setValue(range, forHTTPHeaderField: "Range")
+            let started = CACurrentMediaTime()
+            session.dataTask(with: request) { data, response, _ in
+                let seconds = CACurrentMediaTime() - started
+                let bytes = data?.count ?? 0
+                completion(["status": (response as? HTTPURLResponse)?.statusCode ?? 0, "bytes": bytes, "seconds": seconds, "mb_per_second": Double(bytes) / 1_048_576 / max(seconds, 1e-9)])
+            }.resume()
+        }
+
+        fetch(self.request(for: url, referer: item.pageURL)) { direct in
+            fetch(URLRequest(url: proxied)) { proxy in
+                session.finishTasksAndInvalidate()
+                DispatchQueue.main.async {
+                    completion(["direct": direct, "proxied": proxy])
+                }
+            }
+        }
+    }
+}
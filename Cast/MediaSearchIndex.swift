@@ -0,0 +1,219 @@
+//
+//  MediaSearchIndex.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// In-memory trigram index over the searchable fields of discovered media.
+///
+/// Every word is padded as "  word " before being cut into trigrams, so a
+/// query of a single character still produces one trigram ("  b") that
+/// matches word prefixes. Posting lists hold `documentID << 2 | field` and are
+/// append-only, which keeps them sorted by document because documents are
+/// only ever added in increasing ID order. Not thread safe; use from the
+/// main thread like the rest of the media model.
+final class MediaSearchIndex {
+
+    enum Field: UInt32 {
+        case title = 0
+        case fileName = 1
+        case pageTitle = 2
+
+        var weight: Float {
+            switch self {
+            case .title:
+                return 1.0
+            case .fileName:
+                return 0.8
+            case .pageTitle:
+                return 0.5
+            }
+        }
+    }
+
+    //MARK: Properties
+    // Lists live in an array so appends mutate in place instead of copying out of the dictionary.
+    private var postingSlots: [UInt32: Int] = [:]
+    private var postings: [[UInt32]] = []
+    private let weights: [Float] = [Field.title.weight, Field.fileName.weight, Field.pageTitle.weight]
+    private(set) var documentCount = 0
+
+    // Scratch space reused across queries so a keystroke never allocates per document.
+    private var scores: [Float] = []
+    private var marks: [Int32] = []
+    private var hits: [UInt16] = []
+    private var touched: [Int32] = []
+
+    //MARK: Indexing
+
+    /// Adds a document. IDs must be dense and increasing, starting from 0.
+    func add(documentID: Int, fields: [(Field, String)]) {
+        precondition(documentID == documentCount, "documents must be added in order")
+        documentCount += 1
+        scores.append(0)
+        marks.append(-1)
+        hits.append(0)
+
+        var seen = Set<UInt32>()
+        for (field, text) in fields {
+            seen.removeAll(keepingCapacity: true)
+            MediaSearchIndex.forEachTrigram(in: text, padTrailing: true) { trigram in
+                if seen.insert(trigram).inserted {
+                    let entry = UInt32(documentID) << 2 | field.rawValue
+                    if let slot = postingSlots[trigram] {
+                        postings[slot].append(entry)
+                    } else {
+                        postingSlots[trigram] = postings.count
+                        postings.append([entry])
+                    }
+                }
+            }
+        }
+    }
+
+    //MARK: Querying
+
+    /// Returns document IDs ranked by weighted trigram overlap with `query`.
+    ///
+    /// A document needs to share at least 60% of the query's trigrams, which
+    /// tolerates a typo in longer queries while keeping short ones strict.
+    func search(_ query: String, limit: Int = 200) -> [Int] {
+        var queryTrigrams: [UInt32] = []
+        var unique = Set<UInt32>()
+        MediaSearchIndex.forEachTrigram(in: query, padTrailing: false) { trigram in
+            if unique.insert(trigram).inserted {
+                queryTrigrams.append(trigram)
+            }
+        }
+        if queryTrigrams.isEmpty {
+            return []
+        }
+
+        touched.removeAll(keepingCapacity: true)
+        for (index, trigram) in queryTrigrams.enumerated() {
+            guard let slot = postingSlots[trigram] else {
+                continue
+            }
+            let list = postings[slot]
+            let mark = Int32(index)
+            for entry in list {
+                let document = Int(entry >> 2)
+                // The first posting per document is its best-weighted field.
+                if marks[document] == mark {
+                    continue
+                }
+                if hits[document] == 0 {
+                    touched.append(Int32(document))
+                }
+                marks[document] = mark
+                hits[document] += 1
+                scores[document] += weights[Int(entry & 3)]
+            }
+        }
+
+        let minimumHits = UInt16(max(1, Int((Double(queryTrigrams.count) * 0.6).rounded(.up))))
+        let count = Float(queryTrigrams.count)
+        var best = TopScores(capacity: limit)
+        for document32 in touched {
+            let document = Int(document32)
+            if hits[document] >= minimumHits {
+                best.insert(document: document, score: scores[document] / count)
+            }
+            scores[document] = 0
+            hits[document] = 0
+            marks[document] = -1
+        }
+        return best.sortedDocuments()
+    }
+
+    //MARK: Trigrams
+
+    /// Lower-cases `text`, splits it on anything that is not a letter or digit
+    /// and feeds the packed trigrams of every padded word to `body`. The last
+    /// word of a query is left open so it matches as a prefix while typing.
+    static func forEachTrigram(in text: String, padTrailing: Bool, _ body: (UInt32) -> Void) {
+        var words: [[UInt8]] = []
+        var word: [UInt8] = []
+        for byte in text.lowercased().utf8 {
+            // ASCII letters and digits, plus every byte of a multi-byte UTF-8 sequence.
+            if (byte >= 0x30 && byte <= 0x39) || (byte >= 0x61 && byte <= 0x7a) || byte >= 0x80 {
+                word.append(byte)
+            } else if !word.isEmpty {
+                words.append(word + [0x20])
+                word.removeAll(keepingCapacity: true)
+            }
+        }
+        if !word.isEmpty {
+            words.append(padTrailing ? word + [0x20] : word)
+        }
+
+        for word in words {
+            let padded: [UInt8] = [0x20, 0x20] + word
+            var index = 0
+            while index + 2 < padded.count {
+                body(UInt32(padded[index]) << 16 | UInt32(padded[index + 1]) << 8 | UInt32(padded[index + 2]))
+                index += 1
+            }
+        }
+    }
+}
+
+/// Bounded min-heap keeping the `capacity` best scoring documents. Ties are
+/// broken in favour of the earlier discovered document.
+private struct TopScores {
+
+    private let capacity: Int
+    private var heap: [(document: Int, score: Float)] = []
+
+    init(capacity: Int) {
+        self.capacity = capacity
+        heap.reserveCapacity(capacity)
+    }
+
+    private static func worse(_ a: (document: Int, score: Float), _ b: (document: Int, score: Float)) -> Bool {
+        return a.score < b.score || (a.score == b.score && a.document > b.document)
+    }
+
+    mutating func insert(document: Int, score: Float) {
+        let entry = (document: document, score: score)
+        if heap.count < capacity {
+            heap.append(entry)
+            var child = heap.count - 1
+            while child > 0 {
+                let parent = (child - 1) / 2
+                if !TopScores.worse(heap[child], heap[parent]) {
+                    break
+                }
+                swap(&heap[child], &heap[parent])
+                child = parent
+            }
+        } else if let root = heap.first, TopScores.worse(root, entry) {
+            heap[0] = entry
+            var parent = 0
+            while true {
+                let left = parent * 2 + 1
+                let right = left + 1
+                var smallest = parent
+                if left < heap.count && TopScores.worse(heap[left], heap[smallest]) {
+                    smallest = left
+                }
+                if right < heap.count && TopScores.worse(heap[right], heap[smallest]) {
+                    smallest = right
+                }
+                if smallest == parent {
+                    break
+                }
+                swap(&heap[parent], &heap[smallest])
+                parent = smallest
+            }
+        }
+    }
+
+    func sortedDocuments() -> [Int] {
+        return heap.sorted { TopScores.worse($1, $0) }.map { $0.document }
+    }
+}
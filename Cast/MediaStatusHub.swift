@@ -0,0 +1,275 @@
+//
+//  MediaStatusHub.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import UIKit
+import GoogleCast
+
+struct MediaStatusFields: OptionSet {
+    let rawValue: Int
+
+    static let playerState = MediaStatusFields(rawValue: 1 << 0)
+    static let idleReason = MediaStatusFields(rawValue: 1 << 1)
+    static let position = MediaStatusFields(rawValue: 1 << 2)
+    static let playbackRate = MediaStatusFields(rawValue: 1 << 3)
+    static let volume = MediaStatusFields(rawValue: 1 << 4)
+    static let media = MediaStatusFields(rawValue: 1 << 5)
+    static let queue = MediaStatusFields(rawValue: 1 << 6)
+    static let currentItem = MediaStatusFields(rawValue: 1 << 7)
+    static let preload = MediaStatusFields(rawValue: 1 << 8)
+    static let activeTracks = MediaStatusFields(rawValue: 1 << 9)
+    static let metadata = MediaStatusFields(rawValue: 1 << 10)
+    static let videoInfo = MediaStatusFields(rawValue: 1 << 11)
+
+    static let all = MediaStatusFields(rawValue: (1 << 12) - 1)
+}
+
+/// Value copy of the parts of `GCKMediaStatus` the app reacts to, so two
+/// updates can be compared field by field.
+struct MediaStatusSnapshot {
+    var mediaSessionID = 0
+    var playerState = GCKMediaPlayerState.unknown
+    var idleReason = GCKMediaPlayerIdleReason.none
+    var streamPosition: TimeInterval = 0
+    var playbackRate: Float = 0
+    var volume: Float = 0
+    var isMuted = false
+    var contentID: String?
+    var contentType: String?
+    var streamDuration: TimeInterval = 0
+    var queueItemIDs: [UInt] = []
+    var currentItemID = kGCKMediaQueueInvalidItemID
+    var preloadedItemID = kGCKMediaQueueInvalidItemID
+    var activeTrackIDs: [Int] = []
+    var title: String?
+    var videoWidth = 0
+    var videoHeight = 0
+    /// `CACurrentMediaTime()` when the status this snapshot was taken from arrived.
+    var receivedAt: CFTimeInterval = 0
+
+    init() {
+    }
+
+    init(status: GCKMediaStatus?, receivedAt: CFTimeInterval) {
+        self.receivedAt = receivedAt
+        guard let status = status else {
+            return
+        }
+        mediaSessionID = status.mediaSessionID
+        playerState = status.playerState
+        idleReason = status.idleReason
+        streamPosition = status.streamPosition
+        playbackRate = status.playbackRate
+        volume = status.volume
+        isMuted = status.isMuted
+        contentID = status.mediaInformation?.contentID
+        contentType = status.mediaInformation?.contentType
+        streamDuration = status.mediaInformation?.streamDuration ?? 0
+        queueItemIDs = (0..<status.queueItemCount()).flatMap { status.queueItem(at: $0)?.itemID }
+        currentItemID = status.currentItemID
+        preloadedItemID = status.preloadedItemID
+        activeTrackIDs = (status.activeTrackIDs ?? []).map { $0.intValue }
+        title = status.mediaInformation?.metadata?.string(forKey: kGCKMetadataKeyTitle)
+        videoWidth = Int(status.videoInfo?.width ?? 0)
+        videoHeight = Int(status.videoInfo?.height ?? 0)
+    }
+
+    func changedFields(since other: MediaStatusSnapshot) -> MediaStatusFields {
+        var fields: MediaStatusFields = []
+        if playerState != other.playerState {
+            fields.insert(.playerState)
+        }
+        if idleReason != other.idleReason {
+            fields.insert(.idleReason)
+        }
+        // A fresh status re-anchors the position even when the value repeats.
+        if streamPosition != other.streamPosition || receivedAt != other.receivedAt {
+            fields.insert(.position)
+        }
+        if playbackRate != other.playbackRate {
+            fields.insert(.playbackRate)
+        }
+        if volume != other.volume || isMuted != other.isMuted {
+            fields.insert(.volume)
+        }
+        if mediaSessionID != other.mediaSessionID || contentID != other.contentID || streamDuration != other.streamDuration {
+            fields.insert(.media)
+        }
+        if queueItemIDs != other.queueItemIDs {
+            fields.insert(.queue)
+        }
+        if currentItemID != other.currentItemID {
+            fields.insert(.currentItem)
+        }
+        if preloadedItemID != other.preloadedItemID {
+            fields.insert(.preload)
+        }
+        if activeTrackIDs != other.activeTrackIDs {
+            fields.insert(.activeTracks)
+        }
+        if title != other.title {
+            fields.insert(.metadata)
+        }
+        if videoWidth != other.videoWidth || videoHeight != other.videoHeight {
+            fields.insert(.videoInfo)
+        }
+        return fields
+    }
+}
+
+/// Keeps a subscription alive; dropping it unsubscribes.
+final class MediaStatusSubscription {
+
+    fileprivate let id: Int
+    fileprivate weak var hub: MediaStatusHub?
+
+    fileprivate init(id: Int, hub: MediaStatusHub) {
+        self.id = id
+        self.hub = hub
+    }
+
+    func cancel() {
+        hub?.unsubscribe(id)
+        hub = nil
+    }
+
+    deinit {
+        cancel()
+    }
+}
+
+/// The one `GCKRemoteMediaClientListener` in the app.
+///
+/// Listener callbacks only mark the hub dirty. On the next display frame it
+/// snapshots the latest `GCKMediaStatus`, diffs it against what was published
+/// last and tells each subscriber about the fields it registered for, so a
+/// burst of callbacks during a queue operation costs one publish per frame.
+final class MediaStatusHub: NSObject, GCKRemoteMediaClientListener, GCKSessionManagerListener {
+
+    static let shared = MediaStatusHub()
+
+    typealias Handler = (MediaStatusSnapshot, MediaStatusFields) -> Void
+
+    //MARK: Properties
+    private(set) var snapshot = MediaStatusSnapshot()
+    private var client: GCKRemoteMediaClient?
+    private var forcedFields: MediaStatusFields = []
+    private var statusReceivedAt: CFTimeInterval = 0
+    private var subscribers: [Int: (fields: MediaStatusFields, handler: Handler)] = [:]
+    private var nextSubscriberID = 0
+    private var displayLink: CADisplayLink?
+
+    //MARK: Lifecycle
+
+    /// Starts following the session manager. Call once after the cast
+    /// context has been set up.
+    func start() {
+        let sessionManager = GCKCastContext.sharedInstance().sessionManager
+        sessionManager.add(self)
+        attach(sessionManager.currentCastSession?.remoteMediaClient)
+    }
+
+    private func attach(_ newClient: GCKRemoteMediaClient?) {
+        if newClient === client {
+            return
+        }
+        client?.remove(self)
+        client = newClient
+        client?.add(self)
+        statusReceivedAt = CACurrentMediaTime()
+        scheduleFlush([])
+    }
+
+    //MARK: Subscribing
+
+    /// Calls `handler` on the main thread whenever any of `fields` changes,
+    /// starting with the current snapshot.
+    func subscribe(_ fields: MediaStatusFields, handler: @escaping Handler) -> MediaStatusSubscription {
+        let id = nextSubscriberID
+        nextSubscriberID += 1
+        subscribers[id] = (fields, handler)
+        handler(snapshot, fields)
+        return MediaStatusSubscription(id: id, hub: self)
+    }
+
+    fileprivate func unsubscribe(_ id: Int) {
+        subscribers.removeValue(forKey: id)
+    }
+
+    /// Publishes a snapshot saved by an earlier run, so the controls have
+    /// something to show until the receiver reports in. Ignored once a
+    /// media client is attached.
+    func restore(_ saved: MediaStatusSnapshot) {
+        if client != nil {
+            return
+        }
+        snapshot = saved
+        for (_, subscriber) in subscribers {
+            subscriber.handler(saved, subscriber.fields)
+        }
+    }
+
+    //MARK: Coalescing
+    private func scheduleFlush(_ fields: MediaStatusFields) {
+        forcedFields.formUnion(fields)
+        if displayLink == nil {
+            let link = CADisplayLink(target: self, selector: #selector(flush))
+            link.add(to: .main, forMode: .commonModes)
+            displayLink = link
+        }
+        displayLink?.isPaused = false
+    }
+
+    func flush() {
+        displayLink?.isPaused = true
+
+        let latest = MediaStatusSnapshot(status: client?.mediaStatus, receivedAt: statusReceivedAt)
+        let changed = latest.changedFields(since: snapshot).union(forcedFields)
+        forcedFields = []
+        snapshot = latest
+        if changed.isEmpty {
+            return
+        }
+        for (_, subscriber) in subscribers {
+            let relevant = subscriber.fields.intersection(changed)
+            if !relevant.isEmpty {
+                subscriber.handler(latest, relevant)
+            }
+        }
+    }
+
+    //MARK: GCKRemoteMediaClientListener
+    func remoteMediaClient(_ client: GCKRemoteMediaClient, didUpdate mediaStatus: GCKMediaStatus?) {
+        statusReceivedAt = CACurrentMediaTime()
+        scheduleFlush([])
+    }
+
+    func remoteMediaClientDidUpdateQueue(_ client: GCKRemoteMediaClient) {
+        scheduleFlush(.queue)
+    }
+
+    func remoteMediaClientDidUpdatePreloadStatus(_ client: GCKRemoteMediaClient) {
+        scheduleFlush(.preload)
+    }
+
+    func remoteMediaClient(_ client: GCKRemoteMediaClient, didUpdate mediaMetadata: GCKMediaMetadata?) {
+        scheduleFlush(.metadata)
+    }
+
+    //MARK: GCKSessionManagerListener
+    func sessionManager(_ sessionManager: GCKSessionManager, didStart session: GCKCastSession) {
+        attach(session.remoteMediaClient)
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didResumeCastSession session: GCKCastSession) {
+        attach(session.remoteMediaClient)
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didEnd session: GCKCastSession, withError error: Error?) {
+        attach(nil)
+    }
+}
@@ -7,15 +7,25 @@
 //
 
 import UIKit
-import AVFoundation
 import GoogleCast
 
-class MediaTableViewController: UIViewController, UITableViewDataSource, UITableViewDelegate {
+class MediaTableViewController: UIViewController, UITableViewDataSource, UITableViewDelegate, UISearchBarDelegate {
 
     var videoScreenshots: UIImage!
         
     @IBOutlet weak var tableView: UITableView!
     
+    let searchBar = UISearchBar()
+    var rows: [MediaItem] = []
+    /// Kept apart from the table's selection so items a search hides stay selected.
+    var selectedIDs = Set<Int>()
+    var castItem: UIBarButtonItem!
+    var selectItem: UIBarButtonItem!
+    var castSelectionItem: UIBarButtonItem!
+    var devicesItem: UIBarButtonItem!
+    var diagnosticsItem: UIBarButtonItem!
+    let progressView = PlaybackProgressView(frame: CGRect(x: 0, y: 0, width: 320, height: 30))
+    
     override func viewDidLoad() {
         super.viewDidLoad()
         
@@ -25,88 +35,186 @@ class MediaTableViewController: UIViewController, UITableViewDataSource, UITable
         let frame = CGRect(x: CGFloat(0), y: CGFloat(0), width: CGFloat(24), height: CGFloat(24))
         let castButton = GCKUICastButton(frame: frame)
         //castButton.tintColor = UIColor.blue
-        let item = UIBarButtonItem(customView: castButton)
-        navigationItem.rightBarButtonItem = item
+        castItem = UIBarButtonItem(customView: castButton)
+        selectItem = UIBarButtonItem(title: "Select", style: .plain, target: self, action: #selector(selectPressed))
+        castSelectionItem = UIBarButtonItem(title: "Cast", style: .done, target: self, action: #selector(castSelectionPressed))
+        // Lists remembered TVs while the cast button is still waiting on discovery.
+        devicesItem = UIBarButtonItem(title: "TVs", style: .plain, target: self, action: #selector(devicesPressed))
+        navigationItem.rightBarButtonItems = [castItem, devicesItem, selectItem]
+        diagnosticsItem = UIBarButtonItem(title: "Stats", style: .plain, target: self, action: #selector(diagnosticsPressed))
+        navigationItem.leftItemsSupplementBackButton = true
+        navigationItem.leftBarButtonItem = diagnosticsItem
+        tableView.allowsMultipleSelectionDuringEditing = true
+        
+        searchBar.placeholder = "Search media"
+        searchBar.autocapitalizationType = .none
+        searchBar.autocorrectionType = .no
+        searchBar.delegate = self
+        searchBar.sizeToFit()
+        tableView.tableHeaderView = searchBar
+        tableView.keyboardDismissMode = .onDrag
+        tableView.addGestureRecognizer(UILongPressGestureRecognizer(target: self, action: #selector(rowLongPressed)))
+        
+        progressView.autoresizingMask = .flexibleWidth
+        toolbarItems = [UIBarButtonItem(customView: progressView)]
+        
+        NotificationCenter.default.addObserver(self, selector: #selector(libraryDidChange), name: MediaLibrary.didChangeNotification, object: nil)
         
     }
     
+    deinit {
+        NotificationCenter.default.removeObserver(self)
+    }
+    
+    override func viewWillAppear(_ animated: Bool) {
+        super.viewWillAppear(animated)
+        navigationController?.setToolbarHidden(false, animated: animated)
+    }
+    
+    override func viewWillDisappear(_ animated: Bool) {
+        super.viewWillDisappear(animated)
+        navigationController?.setToolbarHidden(true, animated: animated)
+    }
+    
+    override func viewDidLayoutSubviews() {
+        super.viewDidLayoutSubviews()
+        if let toolbar = navigationController?.toolbar {
+            progressView.frame.size.width = toolbar.bounds.width - 32
+        }
+    }
+    
     override func viewDidAppear(_ animated: Bool) {
         super.viewDidAppear(animated)
-        tableView.reloadData()
+        reloadRows()
         
     }
     
+    func reloadRows() {
+        rows = MediaLibrary.shared.search(searchBar.text ?? "")
+        tableView.reloadData()
+        for (row, item) in rows.enumerated() where selectedIDs.contains(item.id) {
+            tableView.selectRow(at: IndexPath(row: row, section: 0), animated: false, scrollPosition: .none)
+        }
+        updateSelectionButtons()
+    }
+    
+    /// The selected items in library order, including those the search hides.
+    func selectedItems() -> [MediaItem] {
+        return MediaLibrary.shared.items.filter { selectedIDs.contains($0.id) }
+    }
+    
+    func setSelecting(_ selecting: Bool) {
+        selectedIDs.removeAll()
+        tableView.setEditing(selecting, animated: true)
+        navigationItem.setHidesBackButton(selecting, animated: true)
+        navigationItem.leftBarButtonItem = selecting ? UIBarButtonItem(barButtonSystemItem: .cancel, target: self, action: #selector(cancelSelectionPressed)) : diagnosticsItem
+        navigationItem.setRightBarButtonItems(selecting ? [castItem, castSelectionItem] : [castItem, devicesItem, selectItem], animated: true)
+        updateSelectionButtons()
+    }
+    
+    func updateSelectionButtons() {
+        let count = selectedIDs.count
+        castSelectionItem.title = count > 0 ? "Cast (\(count))" : "Cast"
+        castSelectionItem.isEnabled = count > 0
+    }
+    
+    //MARK: Actions
+    func selectPressed() {
+        setSelecting(true)
+    }
+    
+    func cancelSelectionPressed() {
+        setSelecting(false)
+    }
+    
+    func devicesPressed() {
+        let navigationController = UINavigationController(rootViewController: DeviceListViewController(style: .plain))
+        present(navigationController, animated: true, completion: nil)
+    }
+    
+    func diagnosticsPressed() {
+        let navigationController = UINavigationController(rootViewController: DiagnosticsViewController(style: .grouped))
+        present(navigationController, animated: true, completion: nil)
+    }
+    
+    func castSelectionPressed() {
+        // Library order, so the queue plays in the order the videos were found.
+        CastController.shared.loadQueue(selectedItems())
+        setSelecting(false)
+    }
+    
+    func rowLongPressed(_ recognizer: UILongPressGestureRecognizer) {
+        guard recognizer.state == .began, !tableView.isEditing,
+            let indexPath = tableView.indexPathForRow(at: recognizer.location(in: tableView)) else {
+            return
+        }
+        let discoveryManager = GCKCastContext.sharedInstance().discoveryManager
+        let devices = (0..<discoveryManager.deviceCount).map { discoveryManager.device(at: $0) }
+        if devices.count < 2 {
+            return
+        }
+        let item = rows[indexPath.row]
+        let sheet = UIAlertController(title: item.title, message: nil, preferredStyle: .actionSheet)
+        sheet.addAction(UIAlertAction(title: "Cast to all \(devices.count) TVs", style: .default) { _ in
+            MultiDeviceCaster.shared.cast(item, to: devices)
+        })
+        sheet.addAction(UIAlertAction(title: "Cancel", style: .cancel, handler: nil))
+        if let popover = sheet.popoverPresentationController {
+            popover.sourceView = tableView
+            popover.sourceRect = tableView.rectForRow(at: indexPath)
+        }
+        present(sheet, animated: true, completion: nil)
+    }
+    
+    func libraryDidChange() {
+        if isViewLoaded && view.window != nil {
+            reloadRows()
+        }
+    }
+    
+    //MARK: Search bar delegate
+    func searchBar(_ searchBar: UISearchBar, textDidChange searchText: String) {
+        reloadRows()
+    }
+    
+    func searchBarSearchButtonClicked(_ searchBar: UISearchBar) {
+        searchBar.resignFirstResponder()
+    }
+    
+    //MARK: Table view data source
     func tableView(_ tableView: UITableView, numberOfRowsInSection section: Int) -> Int {
-        return 15
+        return rows.count
     }
     
     func tableView(_ tableView: UITableView, cellForRowAt indexPath: IndexPath) -> UITableViewCell {
         
         let cell = tableView.dequeueReusableCell(withIdentifier: "cell") as! MediaTableViewCell
         
-        if ViewController.videoURLs.indices.contains(indexPath.row){
-            cell.videoURL.text = ViewController.videoURLs[indexPath.row]
-            
-        }
+        cell.videoURL.text = rows[indexPath.row].url
         
         return cell
     }
     
+    //MARK: Table view delegate
     func tableView(_ tableView: UITableView, didSelectRowAt indexPath: IndexPath) {
         
-        tableView.cellForRow(at: indexPath)?.isSelected = false
-        
-        let cell = tableView.cellForRow(at: indexPath) as! MediaTableViewCell
-        
-        let metadata = GCKMediaMetadata(metadataType: .generic)
-        metadata.setString(cell.videoURL.text!, forKey: kGCKMetadataKeyTitle)
-        
-        var asset: AVURLAsset!
-        
-        let nsurl = NSString(string: cell.videoURL.text!)
-        
-        if let url = URL(string: nsurl as String){
-            asset = AVURLAsset(url: url)
+        if tableView.isEditing {
+            selectedIDs.insert(rows[indexPath.row].id)
+            updateSelectionButtons()
+            return
         }
         
-        var contentType = ""
+        tableView.deselectRow(at: indexPath, animated: true)
         
-        switch nsurl.pathExtension{
-        case ".flv":
-            contentType = "video/x-flv"
-        case ".mp4":
-            contentType = "video/mp4"
-        case ".m3u8":
-            contentType = "application/x-mpegURL"
-        case ".ts":
-            contentType = "video/MP2T"
-        case ".3gp":
-            contentType = "video/3gpp"
-        case ".mov":
-            contentType = "video/quicktime"
-        case ".avi":
-            contentType = "video/x-msvideo"
-        case ".wmv":
-            contentType = "video/x-ms-wmv"
-        default:
-            break
-            
-        }
-        
-        var mediaInformation: GCKMediaInformation!
-        
-        if asset != nil{
+        // Rows map to library items by ID, so nothing is read back from the cell.
+        CastController.shared.load(rows[indexPath.row])
         
-            mediaInformation = GCKMediaInformation.init(contentID: cell.videoURL.text!, streamType: .unknown, contentType: contentType , metadata: metadata, streamDuration: asset.duration.seconds, customData: nil)
-            
-            
-            let session: GCKCastSession? = GCKCastContext.sharedInstance().sessionManager.currentCastSession
-            
-            if session != nil {
-                session?.remoteMediaClient?.loadMedia(mediaInformation)
-            }
-                
+    }
+    
+    func tableView(_ tableView: UITableView, didDeselectRowAt indexPath: IndexPath) {
+        if tableView.isEditing {
+            selectedIDs.remove(rows[indexPath.row].id)
+            updateSelectionButtons()
         }
-        
     }
 }
@@ -0,0 +1,277 @@
+//
+//  MultiDeviceCaster.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+import GoogleCast
+
+/// One receiver in a fan-out, with its own connection and media channel.
+///
+/// `GCKSessionManager` only ever holds one session, so every device gets a
+/// `GCKDeviceManager` of its own that launches the default media receiver.
+/// Its requests go through `CastRequestTracker` like the session's do.
+/// Status round trips are timed to estimate the one-way delay to it.
+final class FanOutReceiver: NSObject, GCKDeviceManagerDelegate, GCKMediaControlChannelDelegate {
+
+    enum State {
+        case connecting
+        case ready
+        case loading
+        case loaded
+        case failed
+    }
+
+    //MARK: Properties
+    let device: GCKDevice
+    let channel = GCKMediaControlChannel()
+    fileprivate(set) var state = State.connecting
+    /// Smoothed half round trip of status requests.
+    private(set) var oneWayDelay: TimeInterval = 0
+    fileprivate var onChange: (() -> Void)?
+
+    private let deviceManager: GCKDeviceManager
+
+    //MARK: Lifecycle
+    init(device: GCKDevice) {
+        self.device = device
+        deviceManager = GCKDeviceManager(device: device, clientPackageName: Bundle.main.bundleIdentifier ?? "Cast", ignoreAppStateNotifications: true)
+        super.init()
+        deviceManager.delegate = self
+        channel.delegate = self
+    }
+
+    func connect() {
+        state = .connecting
+        deviceManager.connect()
+    }
+
+    func disconnect() {
+        CastRequestTracker.shared.cancelRequests(on: channel)
+        deviceManager.disconnect()
+    }
+
+    //MARK: Commands
+
+    /// Sends a status request and times its round trip.
+    func probe() {
+        let sent = CACurrentMediaTime()
+        CastRequestTracker.shared.issue(.status, on: channel, send: { $0.requestStatus() }) { [weak self] outcome in
+            guard let strongSelf = self, case .completed = outcome else {
+                return
+            }
+            let sample = (CACurrentMediaTime() - sent) / 2
+            strongSelf.oneWayDelay = strongSelf.oneWayDelay == 0 ? sample : strongSelf.oneWayDelay * 0.7 + sample * 0.3
+        }
+    }
+
+    func load(_ information: GCKMediaInformation, playPosition: TimeInterval) {
+        state = .loading
+        CastRequestTracker.shared.issue(.load, on: channel, send: { $0.loadMedia(information, autoplay: false, playPosition: playPosition) }) { [weak self] outcome in
+            guard let strongSelf = self, strongSelf.state == .loading else {
+                return
+            }
+            if case .completed = outcome {
+                strongSelf.state = .loaded
+                strongSelf.onChange?()
+            } else {
+                strongSelf.fail()
+            }
+        }
+    }
+
+    /// Sent once: a retried play would land late and undo the alignment.
+    func play() {
+        CastRequestTracker.shared.issue(.play, on: channel, retrying: false, send: { $0.play() })
+    }
+
+    /// Receiver position projected to now, including the time the last
+    /// status spent in flight.
+    func estimatedPosition() -> TimeInterval? {
+        guard let status = channel.mediaStatus else {
+            return nil
+        }
+        let rate = status.playerState == .playing ? Double(status.playbackRate) : 0
+        return status.streamPosition + (channel.timeSinceLastMediaStatusUpdate + oneWayDelay) * rate
+    }
+
+    private func fail() {
+        state = .failed
+        onChange?()
+    }
+
+    //MARK: GCKDeviceManagerDelegate
+    func deviceManagerDidConnect(_ deviceManager: GCKDeviceManager) {
+        deviceManager.launchApplication(kGCKMediaDefaultReceiverApplicationID)
+    }
+
+    func deviceManager(_ deviceManager: GCKDeviceManager, didFailToConnectWithError error: Error) {
+        fail()
+    }
+
+    func deviceManager(_ deviceManager: GCKDeviceManager, didConnectToCastApplication applicationMetadata: GCKApplicationMetadata, sessionID: String, launchedApplication: Bool) {
+        deviceManager.add(channel)
+        state = .ready
+        // A few round trips give the delay estimate something to average.
+        for _ in 0..<3 {
+            probe()
+        }
+        onChange?()
+    }
+
+    func deviceManager(_ deviceManager: GCKDeviceManager, didFailToConnectToApplicationWithError error: Error) {
+        fail()
+    }
+
+    func deviceManager(_ deviceManager: GCKDeviceManager, didDisconnectWithError error: Error?) {
+        if state != .failed {
+            fail()
+        }
+    }
+
+    //MARK: GCKMediaControlChannelDelegate
+    func mediaControlChannel(_ mediaControlChannel: GCKMediaControlChannel, requestDidCompleteWithID requestID: Int) {
+        CastRequestTracker.shared.channel(mediaControlChannel, requestDidCompleteWithID: requestID)
+    }
+
+    func mediaControlChannel(_ mediaControlChannel: GCKMediaControlChannel, requestDidFailWithID requestID: Int, error: Error) {
+        CastRequestTracker.shared.channel(mediaControlChannel, requestDidFailWithID: requestID, error: error)
+    }
+
+    func mediaControlChannel(_ mediaControlChannel: GCKMediaControlChannel, didCancelRequestWithID requestID: Int) {
+        CastRequestTracker.shared.channel(mediaControlChannel, requestDidAbortWithID: requestID, reason: .cancelled)
+    }
+
+    func mediaControlChannel(_ mediaControlChannel: GCKMediaControlChannel, didReplaceRequestWithID requestID: Int) {
+        CastRequestTracker.shared.channel(mediaControlChannel, requestDidAbortWithID: requestID, reason: .replaced)
+    }
+}
+
+/// Starts the same media on several TVs at once.
+///
+/// Every device is connected and loaded paused in parallel. Once all have
+/// loaded, `play` is sent to each one delayed by how much nearer it is than
+/// the farthest, so the commands land together. A moment later all
+/// positions are sampled at one local instant; their spread is the skew.
+final class MultiDeviceCaster {
+
+    static let shared = MultiDeviceCaster()
+
+    //MARK: Properties
+    /// Devices not ready by then are left out of the start.
+    var connectTimeout: TimeInterval = 15
+    /// How long after the start to sample positions for the skew.
+    var skewSampleDelay: TimeInterval = 3
+
+    private(set) var receivers: [FanOutReceiver] = []
+    private(set) var skews = LatencyHistogram()
+    private(set) var lastSkew: TimeInterval?
+
+    private var information: GCKMediaInformation?
+    private var playPosition: TimeInterval = 0
+    private var started = false
+    private var generation = 0
+
+    //MARK: Methods
+    func cast(_ item: MediaItem, to devices: [GCKDevice], playPosition: TimeInterval = 0) {
+        stop()
+        information = MediaInformationCache.shared.information(for: item)
+        self.playPosition = playPosition
+        let generation = self.generation
+        receivers = devices.map { FanOutReceiver(device: $0) }
+        for receiver in receivers {
+            receiver.onChange = { [weak self] in
+                self?.advance()
+            }
+            receiver.connect()
+        }
+        DispatchQueue.main.asyncAfter(deadline: .now() + connectTimeout) { [weak self] in
+            guard let strongSelf = self, strongSelf.generation == generation else {
+                return
+            }
+            // Go with whoever made it.
+            for receiver in strongSelf.receivers where receiver.state == .connecting {
+                receiver.state = .failed
+            }
+            strongSelf.advance()
+        }
+    }
+
+    func stop() {
+        generation += 1
+        for receiver in receivers {
+            receiver.onChange = nil
+            receiver.disconnect()
+        }
+        receivers = []
+        information = nil
+        started = false
+    }
+
+    private func advance() {
+        let alive = receivers.filter { $0.state != .failed }
+        guard let information = information, !alive.isEmpty, !started else {
+            return
+        }
+        if alive.contains(where: { $0.state == .connecting }) {
+            return
+        }
+        for receiver in alive where receiver.state == .ready {
+            receiver.load(information, playPosition: playPosition)
+        }
+        if alive.contains(where: { $0.state != .loaded }) {
+            return
+        }
+        started = true
+        startAligned(alive)
+    }
+
+    private func startAligned(_ alive: [FanOutReceiver]) {
+        let farthest = alive.map { $0.oneWayDelay }.max() ?? 0
+        let generation = self.generation
+        for receiver in alive {
+            DispatchQueue.main.asyncAfter(deadline: .now() + (farthest - receiver.oneWayDelay)) { [weak self] in
+                // A stop inside the alignment window has torn these receivers down.
+                if self?.generation == generation {
+                    receiver.play()
+                }
+            }
+        }
+        DispatchQueue.main.asyncAfter(deadline: .now() + farthest + skewSampleDelay) { [weak self] in
+            guard let strongSelf = self, strongSelf.generation == generation else {
+                return
+            }
+            for receiver in alive {
+                receiver.probe()
+            }
+            // Give the fresh statuses time to arrive before sampling them together.
+            DispatchQueue.main.asyncAfter(deadline: .now() + farthest * 2 + 0.5) {
+                if strongSelf.generation == generation {
+                    strongSelf.sampleSkew(alive)
+                }
+            }
+        }
+    }
+
+    private func sampleSkew(_ alive: [FanOutReceiver]) {
+        let positions = alive.flatMap { $0.estimatedPosition() }
+        guard positions.count > 1, let lowest = positions.min(), let highest = positions.max() else {
+            return
+        }
+        lastSkew = highest - lowest
+        skews.record(highest - lowest)
+    }
+
+    /// Per-device delay estimates and the skew distribution.
+    func statistics() -> [String: Any] {
+        var devices: [String: Any] = [:]
+        for receiver in receivers {
+            devices[receiver.device.friendlyName ?? receiver.device.uniqueID] = ["one_way_delay_ms": receiver.oneWayDelay * 1000, "state": "\(receiver.state)"]
+        }
+        return ["devices": devices, "skew": skews.summary(), "last_skew_ms": (lastSkew ?? 0) * 1000]
+    }
+}
@@ -0,0 +1,171 @@
+//
+//  OriginStandIn.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+
+/// A slow HLS origin on the local media server, for measuring the read-ahead
+/// cache without a real CDN.
+///
+/// `/origin/<name>/index.m3u8` is a video-on-demand playlist of
+/// `segmentCount` segments, and each segment is held back `firstByteDelay`
+/// and then sent at `bytesPerSecond` per connection.
+final class OriginStandIn {
+
+    static let prefix = "/origin/"
+
+    //MARK: Properties
+    var segmentCount = 8
+    var segmentDuration: TimeInterval = 2
+    var segmentBytes = 384 << 10
+    var firstByteDelay: TimeInterval = 0.4
+    var bytesPerSecond = 256 << 10
+    private let queue = DispatchQueue(label: "OriginStandIn")
+
+    //MARK: Lifecycle
+    func start() -> Bool {
+        guard LocalMediaServer.shared.start() else {
+            return false
+        }
+        LocalMediaServer.shared.register(OriginStandIn.prefix) { [weak self] request in
+            self?.handle(request) ?? .error(503)
+        }
+        return true
+    }
+
+    func stop() {
+        LocalMediaServer.shared.unregister(OriginStandIn.prefix)
+    }
+
+    /// Loopback URL of a playlist; a new name keeps earlier runs out of the cache.
+    func playlistURL(named name: String) -> URL {
+        return URL(string: "http://127.0.0.1:\(LocalMediaServer.shared.port)\(OriginStandIn.prefix)\(name)/index.m3u8")!
+    }
+
+    //MARK: Serving
+    private func handle(_ request: HTTPRequest) -> HTTPResponse {
+        let name = request.path.components(separatedBy: "/").last ?? ""
+        if name == "index.m3u8" {
+            var lines = ["#EXTM3U", "#EXT-X-VERSION:3", "#EXT-X-TARGETDURATION:\(Int(ceil(segmentDuration)))", "#EXT-X-MEDIA-SEQUENCE:0"]
+            for index in 0..<segmentCount {
+                lines += ["#EXTINF:\(segmentDuration),", "segment\(index).ts"]
+            }
+            lines.append("#EXT-X-ENDLIST")
+            return HTTPResponse(status: 200, headers: [("Content-Type", "application/vnd.apple.mpegurl")], body: .data((lines.joined(separator: "\n") + "\n").data(using: .utf8)!))
+        }
+        guard name.hasPrefix("segment") && name.hasSuffix(".ts") else {
+            return .error(404)
+        }
+        let stream = HTTPStream()
+        stream.respond(HTTPStream.Head(status: 200, headers: [("Content-Type", "video/MP2T")], contentLength: Int64(segmentBytes)))
+        let chunk = 16 << 10
+        let interval = Double(chunk) / Double(max(bytesPerSecond, 1))
+        let zeros = Data(count: chunk)
+        var remaining = segmentBytes
+        var cancelled = false
+        let queue = self.queue
+        stream.onCancel = {
+            queue.async {
+                cancelled = true
+            }
+        }
+
+        func send() {
+            guard !cancelled else {
+                return
+            }
+            let count = min(chunk, remaining)
+            _ = stream.write(count == chunk ? zeros : zeros.subdata(in: 0..<count))
+            remaining -= count
+            if remaining > 0 {
+                queue.asyncAfter(deadline: .now() + interval, execute: send)
+            } else {
+                stream.finish()
+            }
+        }
+        queue.asyncAfter(deadline: .now() + firstByteDelay, execute: send)
+        return HTTPResponse(status: 200, body: .stream(stream))
+    }
+
+    //MARK: Benchmark
+
+    /// Plays the stand-in through the proxy twice, without and then with the
+    /// prefetcher, as a player holding two segments ahead would. Reports
+    /// rebuffers and per-segment fetch times. Calls back on the main thread.
+    func compareReadAhead(completion: @escaping ([String: Any]) -> Void) {
+        guard start() else {
+            completion([:])
+            return
+        }
+        MediaProxy.shared.start()
+        let prefetcher = SegmentPrefetcher.shared
+        let wasEnabled = prefetcher.isEnabled
+        let run = UUID().uuidString
+        let session = URLSession(configuration: .ephemeral)
+
+        func fetch(_ url: URL) -> Data? {
+            var result: Data?
+            let done = DispatchSemaphore(value: 0)
+            session.dataTask(with: url) { data, _, _ in
+                result = data
+                done.signal()
+            }.resume()
+            done.wait()
+            return result
+        }
+
+        func play(prefetching: Bool) -> [String: Any] {
+            prefetcher.isEnabled = prefetching
+            let origin = playlistURL(named: run + (prefetching ? "-on" : "-off"))
+            let proxied = URL(string: "http://127.0.0.1:\(LocalMediaServer.shared.port)" + MediaProxy.path(for: origin, referer: ""))!
+            guard let text = fetch(proxied).flatMap({ String(data: $0, encoding: .utf8) }),
+                let playlist = HLSPlaylist(text: text, baseURL: proxied) else {
+                return ["error": "no playlist"]
+            }
+            let ahead = 2
+            var fetchTimes = LatencyHistogram()
+            var playbackStart: CFTimeInterval?
+            var stalled: TimeInterval = 0
+            var rebuffers = 0
+            for (index, segment) in playlist.segments.enumerated() {
+                if let playbackStart = playbackStart {
+                    // Wait for room in the buffer.
+                    let wait = playbackStart + stalled + Double(index - ahead) * segmentDuration - CACurrentMediaTime()
+                    if wait > 0 {
+                        Thread.sleep(forTimeInterval: wait)
+                    }
+                }
+                let requested = CACurrentMediaTime()
+                _ = fetch(segment.url)
+                let arrived = CACurrentMediaTime()
+                fetchTimes.record(arrived - requested)
+                guard let started = playbackStart else {
+                    playbackStart = arrived
+                    continue
+                }
+                let due = started + stalled + Double(index) * segmentDuration
+                if arrived > due {
+                    rebuffers += 1
+                    stalled += arrived - due
+                }
+            }
+            return ["rebuffers": rebuffers, "stalled_seconds": stalled, "segment_fetch": fetchTimes.summary()]
+        }
+
+        DispatchQueue.global().async {
+            let direct = play(prefetching: false)
+            let prefetched = play(prefetching: true)
+            prefetcher.isEnabled = wasEnabled
+            session.finishTasksAndInvalidate()
+            DispatchQueue.main.async {
+                self.stop()
+                completion(["without_prefetch": direct, "with_prefetch": prefetched, "prefetcher": prefetcher.statistics()])
+            }
+        }
+    }
+}
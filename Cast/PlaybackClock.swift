@@ -0,0 +1,192 @@
+//
+//  PlaybackClock.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import UIKit
+import GoogleCast
+
+/// Keeps time for the media playing on the receiver without asking it.
+///
+/// Each status update re-anchors the clock at the reported position plus the
+/// estimated one-way delay. Small disagreements are slewed away over
+/// `slewDuration` so the displayed time never jumps; large ones (a seek,
+/// a new item) snap. The remaining error between updates is folded into a
+/// drift estimate that scales the local rate. Observers are ticked from a
+/// display link, which only runs while something is observing.
+final class PlaybackClock {
+
+    static let shared = PlaybackClock()
+
+    typealias Observer = (TimeInterval, TimeInterval) -> Void
+
+    //MARK: Properties
+    var slewDuration: TimeInterval = 1
+    var snapThreshold: TimeInterval = 1
+    /// Upper bound on the relative rate correction, 2%.
+    var maximumDrift = 0.02
+
+    private(set) var duration: TimeInterval = 0
+    private var anchorTime: CFTimeInterval = 0
+    private var anchorPosition: TimeInterval = 0
+    private var rate: Double = 0
+    private var drift: Double = 0
+    private var pendingError: TimeInterval = 0
+    private var mediaSessionID = 0
+    /// While a seek is outstanding, reported positions are stale and only the
+    /// rate and duration are taken from status updates.
+    private var isHeld = false
+    /// The first update after a hold measures the seek, not drift.
+    private var isSettling = false
+
+    private var subscription: MediaStatusSubscription?
+    private var observers: [Int: Observer] = [:]
+    private var nextObserverID = 0
+    private var displayLink: CADisplayLink?
+
+    //MARK: Lifecycle
+    func start() {
+        subscription = MediaStatusHub.shared.subscribe([.position, .playerState, .playbackRate, .media]) { [weak self] snapshot, _ in
+            self?.update(with: snapshot)
+        }
+    }
+
+    //MARK: Reading
+
+    /// Estimated receiver position at local time `time`.
+    func position(at time: CFTimeInterval = CACurrentMediaTime()) -> TimeInterval {
+        let elapsed = max(0, time - anchorTime)
+        var position = anchorPosition + elapsed * rate * (1 + drift)
+        if slewDuration > 0 {
+            position += pendingError * min(1, elapsed / slewDuration)
+        }
+        return duration > 0 ? min(max(0, position), duration) : max(0, position)
+    }
+
+    var isRunning: Bool {
+        return rate != 0
+    }
+
+    //MARK: Anchoring
+    private func update(with snapshot: MediaStatusSnapshot) {
+        duration = snapshot.streamDuration
+        let newRate = snapshot.playerState == .playing ? Double(snapshot.playbackRate) : 0
+        if isHeld {
+            anchorPosition = position()
+            anchorTime = CACurrentMediaTime()
+            rate = newRate
+            mediaSessionID = snapshot.mediaSessionID
+            tick()
+            updateDisplayLink()
+            return
+        }
+        let delay = CastRequestTracker.shared.oneWayDelay
+        // The status left the receiver `delay` ago and has been moving since.
+        let target = snapshot.streamPosition + delay * newRate
+        let now = snapshot.receivedAt
+
+        let sameMedia = snapshot.mediaSessionID == mediaSessionID && snapshot.mediaSessionID != 0
+        let predicted = position(at: now)
+        let error = target - predicted
+
+        if sameMedia && rate != 0 && newRate == rate && abs(error) < snapThreshold {
+            // Whatever is left of the error since the last anchor is drift between the clocks.
+            let interval = now - anchorTime
+            if interval > 0.5 && !isSettling {
+                let observed = error / (interval * rate)
+                drift = min(maximumDrift, max(-maximumDrift, drift * 0.8 + observed * 0.2))
+            }
+            anchorPosition = predicted
+            pendingError = error
+        } else {
+            if !sameMedia {
+                drift = 0
+                if delay == 0 && snapshot.mediaSessionID != 0 {
+                    // One status round trip gives the delay estimate something to start from.
+                    CastController.shared.requestStatus()
+                }
+            }
+            anchorPosition = target
+            pendingError = 0
+        }
+        anchorTime = now
+        rate = newRate
+        mediaSessionID = snapshot.mediaSessionID
+        isSettling = false
+        tick()
+        updateDisplayLink()
+    }
+
+    //MARK: Seeking
+
+    /// Shows `position` right away and stops taking positions from the
+    /// receiver until `release()`, so a pending seek does not flicker back.
+    func hold(at position: TimeInterval) {
+        isHeld = true
+        anchorPosition = duration > 0 ? min(max(0, position), duration) : max(0, position)
+        anchorTime = CACurrentMediaTime()
+        pendingError = 0
+        tick()
+    }
+
+    func release() {
+        if isHeld {
+            isHeld = false
+            isSettling = true
+        }
+    }
+
+    //MARK: Observing
+
+    /// Calls `observer` with (position, duration) on every display refresh
+    /// while playing, and once whenever the clock is re-anchored.
+    func addObserver(_ observer: @escaping Observer) -> Int {
+        let id = nextObserverID
+        nextObserverID += 1
+        observers[id] = observer
+        observer(position(), duration)
+        updateDisplayLink()
+        return id
+    }
+
+    func removeObserver(_ id: Int) {
+        observers.removeValue(forKey: id)
+        updateDisplayLink()
+    }
+
+    fileprivate func tick() {
+        let now = position()
+        for (_, observer) in observers {
+            observer(now, duration)
+        }
+    }
+
+    private func updateDisplayLink() {
+        let shouldRun = isRunning && !observers.isEmpty
+        if shouldRun && displayLink == nil {
+            let link = CADisplayLink(target: DisplayLinkTarget(clock: self), selector: #selector(DisplayLinkTarget.step))
+            link.add(to: .main, forMode: .commonModes)
+            displayLink = link
+        } else if !shouldRun, let link = displayLink {
+            link.invalidate()
+            displayLink = nil
+        }
+    }
+}
+
+/// CADisplayLink retains its target; this keeps the clock itself out of that cycle.
+private final class DisplayLinkTarget: NSObject {
+
+    weak var clock: PlaybackClock?
+
+    init(clock: PlaybackClock) {
+        self.clock = clock
+    }
+
+    @objc func step() {
+        clock?.tick()
+    }
+}
@@ -0,0 +1,114 @@
+//
+//  PlaybackProgressView.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import UIKit
+
+/// Elapsed time, position slider and remaining time of the media playing on
+/// the receiver, driven by `PlaybackClock`. Dragging the slider seeks through
+/// `SeekEngine`.
+class PlaybackProgressView: UIView {
+
+    //MARK: Properties
+    let elapsedLabel = UILabel()
+    let slider = UISlider()
+    let remainingLabel = UILabel()
+
+    private var observerID: Int?
+
+    //MARK: Methods
+    override init(frame: CGRect) {
+        super.init(frame: frame)
+        setUp()
+    }
+
+    required init?(coder aDecoder: NSCoder) {
+        super.init(coder: aDecoder)
+        setUp()
+    }
+
+    deinit {
+        if let observerID = observerID {
+            PlaybackClock.shared.removeObserver(observerID)
+        }
+    }
+
+    private func setUp() {
+        for label in [elapsedLabel, remainingLabel] {
+            label.font = UIFont.monospacedDigitSystemFont(ofSize: 12, weight: UIFontWeightRegular)
+            label.text = "--:--"
+            label.setContentHuggingPriority(UILayoutPriorityRequired, for: .horizontal)
+            label.setContentCompressionResistancePriority(UILayoutPriorityRequired, for: .horizontal)
+        }
+        slider.isContinuous = true
+        slider.addTarget(self, action: #selector(sliderMoved), for: .valueChanged)
+        slider.addTarget(self, action: #selector(sliderReleased), for: [.touchUpInside, .touchUpOutside, .touchCancel])
+
+        let stack = UIStackView(arrangedSubviews: [elapsedLabel, slider, remainingLabel])
+        stack.axis = .horizontal
+        stack.alignment = .center
+        stack.spacing = 8
+        stack.translatesAutoresizingMaskIntoConstraints = false
+        addSubview(stack)
+        NSLayoutConstraint.activate([
+            stack.leadingAnchor.constraint(equalTo: leadingAnchor),
+            stack.trailingAnchor.constraint(equalTo: trailingAnchor),
+            stack.topAnchor.constraint(equalTo: topAnchor),
+            stack.bottomAnchor.constraint(equalTo: bottomAnchor)
+        ])
+    }
+
+    override func didMoveToWindow() {
+        super.didMoveToWindow()
+        // Only tick the clock while the view can actually be seen.
+        if window != nil && observerID == nil {
+            observerID = PlaybackClock.shared.addObserver { [weak self] position, duration in
+                self?.show(position: position, duration: duration)
+            }
+        } else if window == nil, let observerID = observerID {
+            PlaybackClock.shared.removeObserver(observerID)
+            self.observerID = nil
+        }
+    }
+
+    func sliderMoved() {
+        SeekEngine.shared.scrub(to: TimeInterval(slider.value))
+    }
+
+    func sliderReleased() {
+        SeekEngine.shared.commit(to: TimeInterval(slider.value))
+    }
+
+    func show(position: TimeInterval, duration: TimeInterval) {
+        elapsedLabel.text = PlaybackProgressView.format(position)
+        // Live streams report an infinite duration, and have no end to count down to.
+        let isFinite = duration.isFinite && duration > 0
+        slider.isEnabled = isFinite
+        if isFinite {
+            slider.maximumValue = Float(duration)
+            if !slider.isTracking {
+                slider.value = Float(position)
+            }
+            remainingLabel.text = "-" + PlaybackProgressView.format(duration - position)
+        } else {
+            slider.maximumValue = 1
+            slider.value = 0
+            remainingLabel.text = "--:--"
+        }
+    }
+
+    static func format(_ time: TimeInterval) -> String {
+        guard time.isFinite else {
+            return "--:--"
+        }
+        let seconds = Int(max(0, time))
+        if seconds >= 3600 {
+            return String(format: "%d:%02d:%02d", seconds / 3600, seconds / 60 % 60, seconds % 60)
+        }
+        return String(format: "%d:%02d", seconds / 60, seconds % 60)
+    }
+}
@@ -0,0 +1,170 @@
+//
+//  QueueWindowManager.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import GoogleCast
+
+/// Plays a playlist of any length while only keeping `radius` items on each
+/// side of the current one loaded on the receiver.
+///
+/// The whole playlist stays here. Every receiver queue item carries its
+/// playlist index in `customData`, so the window can be rebuilt from any
+/// `GCKMediaStatus` without tracking receiver item IDs ourselves. At most one
+/// insert or remove is in flight at a time; its completion triggers the next
+/// reconcile step. A failed one is tried again after a growing delay, and
+/// after `maximumFailures` in a row the window is left as it is.
+final class QueueWindowManager {
+
+    static let shared = QueueWindowManager()
+    static let playlistIndexKey = "playlistIndex"
+
+    //MARK: Properties
+    var radius = 10
+    /// Upper bound on items sent in one insert, to keep each message small.
+    var batchSize = 10
+    var maximumFailures = 4
+    /// The delay before the first retry; it doubles with each failure after.
+    var retryDelay: TimeInterval = 1
+    private(set) var playlist: [MediaItem] = []
+    private var client: GCKRemoteMediaClient?
+    private var subscription: MediaStatusSubscription?
+    private var busy = false
+    private var failures = 0
+    /// Bumped by `stop()` so completions of an abandoned playlist are ignored.
+    private var generation = 0
+
+    //MARK: Methods
+
+    /// Replaces the receiver queue with the window around `startIndex`.
+    func start(_ items: [MediaItem], startIndex: Int, on client: GCKRemoteMediaClient, completion: CastRequestTracker.Completion? = nil) {
+        stop()
+        if items.isEmpty {
+            return
+        }
+        playlist = items
+        self.client = client
+
+        let lower = max(0, startIndex - radius)
+        let upper = min(items.count - 1, startIndex + radius)
+        let window = queueItems(lower...upper)
+        send(.queueLoad, completion: completion) { client in
+            client.queueLoadItems(window, startIndex: UInt(startIndex - lower), repeatMode: .off)
+        }
+        // Subscribed after the load is in flight, so the old queue is not mistaken for a foreign one.
+        subscription = MediaStatusHub.shared.subscribe([.queue, .currentItem]) { [weak self] _, _ in
+            self?.reconcile()
+        }
+    }
+
+    func stop() {
+        subscription = nil
+        client = nil
+        busy = false
+        failures = 0
+        generation += 1
+        playlist = []
+    }
+
+    //MARK: Reconciling
+
+    private func reconcile() {
+        guard !busy, let client = client, let status = client.mediaStatus else {
+            return
+        }
+
+        // Receiver order is playlist order, since we only ever append, prepend or trim.
+        var loaded: [(itemID: UInt, index: Int)] = []
+        for position in 0..<status.queueItemCount() {
+            guard let item = status.queueItem(at: position),
+                let customData = item.customData as? [String: Any],
+                let index = customData[QueueWindowManager.playlistIndexKey] as? Int else {
+                continue
+            }
+            loaded.append((item.itemID, index))
+        }
+        if loaded.isEmpty {
+            // Something else replaced our queue.
+            if status.queueItemCount() > 0 {
+                stop()
+            }
+            return
+        }
+        guard let current = loaded.first(where: { $0.itemID == status.currentItemID }) else {
+            return
+        }
+
+        let wantedLower = max(0, current.index - radius)
+        let wantedUpper = min(playlist.count - 1, current.index + radius)
+        let first = loaded.first!
+        let last = loaded.last!
+
+        if last.index < wantedUpper {
+            let items = queueItems((last.index + 1)...min(wantedUpper, last.index + batchSize))
+            send(.queueInsert) { client in
+                client.queueInsertItems(items, beforeItemWithID: kGCKMediaQueueInvalidItemID)
+            }
+        } else if first.index > wantedLower {
+            let items = queueItems(max(wantedLower, first.index - batchSize)...(first.index - 1))
+            send(.queueInsert) { client in
+                client.queueInsertItems(items, beforeItemWithID: first.itemID)
+            }
+        } else {
+            let stale = loaded.filter { $0.index < wantedLower || $0.index > wantedUpper }.map { NSNumber(value: $0.itemID) }
+            if !stale.isEmpty {
+                send(.queueRemove) { client in
+                    client.queueRemoveItems(withIDs: stale)
+                }
+            }
+        }
+    }
+
+    private func queueItems(_ range: CountableClosedRange<Int>) -> [GCKMediaQueueItem] {
+        return range.map { index in
+            CastController.shared.makeQueueItem(for: playlist[index], customData: [QueueWindowManager.playlistIndexKey: index])
+        }
+    }
+
+    private func send(_ command: CastCommand, completion: CastRequestTracker.Completion? = nil, _ body: @escaping (GCKRemoteMediaClient) -> GCKRequest) {
+        guard let client = client else {
+            return
+        }
+        busy = true
+        let generation = self.generation
+        CastRequestTracker.shared.issue(command, send: {
+            body(client)
+        }, completion: { [weak self] outcome in
+            completion?(outcome)
+            guard let strongSelf = self, strongSelf.generation == generation else {
+                return
+            }
+            switch outcome {
+            case .completed:
+                strongSelf.failures = 0
+                strongSelf.busy = false
+                strongSelf.reconcile()
+            case .failed:
+                strongSelf.failures += 1
+                if strongSelf.failures >= strongSelf.maximumFailures {
+                    strongSelf.stop()
+                    return
+                }
+                // Still busy meanwhile, so status updates do not send it again early.
+                DispatchQueue.main.asyncAfter(deadline: .now() + strongSelf.retryDelay * pow(2, Double(strongSelf.failures - 1))) {
+                    guard strongSelf.generation == generation else {
+                        return
+                    }
+                    strongSelf.busy = false
+                    strongSelf.reconcile()
+                }
+            case .aborted:
+                // Cancelled with the session, or replaced by a newer request whose status will reconcile.
+                strongSelf.busy = false
+            }
+        })
+    }
+}
@@ -0,0 +1,114 @@
+//
+//  ReceiverPrewarmer.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+import GoogleCast
+
+/// Gets the receiver and the likely first item ready while the user is still
+/// looking at the device list.
+///
+/// Picking a device in the cast dialog starts the session and launches the
+/// receiver app. As soon as that begins, the top library items have their
+/// duration and MIME type resolved. Once the session is up, one status round
+/// trip opens the media channel. The first load of each session is timed
+/// and filed as warm or cold, so the time saved can be read off `statistics()`.
+final class ReceiverPrewarmer: NSObject, GCKSessionManagerListener {
+
+    static let shared = ReceiverPrewarmer()
+
+    //MARK: Properties
+    /// Turn off to collect cold first-load timings for comparison.
+    var isEnabled = true
+    /// How many of the top library items to resolve ahead of the first tap.
+    var candidateCount = 3
+
+    private(set) var isWarm = false
+    private var awaitingFirstLoad = false
+    private(set) var warmFirstLoads = LatencyHistogram()
+    private(set) var coldFirstLoads = LatencyHistogram()
+    private(set) var warmUps = LatencyHistogram()
+
+    //MARK: Lifecycle
+    func start() {
+        GCKCastContext.sharedInstance().sessionManager.add(self)
+    }
+
+    private func prepareCandidates() {
+        for item in MediaLibrary.shared.items.prefix(candidateCount) {
+            MediaInformationCache.shared.prepare(item)
+            MediaInformationCache.shared.resolveContentType(item)
+        }
+    }
+
+    private func warmUp() {
+        let started = CACurrentMediaTime()
+        CastController.shared.requestStatus { [weak self] outcome in
+            guard let strongSelf = self, case .completed = outcome else {
+                return
+            }
+            strongSelf.warmUps.record(CACurrentMediaTime() - started)
+            strongSelf.isWarm = true
+        }
+    }
+
+    //MARK: Measuring
+
+    /// Wraps the completion of a load so the first one of each session is
+    /// timed. A load counts as warm if the warm-up had finished and its item
+    /// was fully resolved when it was issued.
+    func timingFirstLoad(of item: MediaItem?, _ completion: CastRequestTracker.Completion?) -> CastRequestTracker.Completion? {
+        guard awaitingFirstLoad else {
+            return completion
+        }
+        awaitingFirstLoad = false
+        let warm = isWarm && (item.map { MediaInformationCache.shared.isResolved($0) } ?? true)
+        let issued = CACurrentMediaTime()
+        return { [weak self] outcome in
+            if let strongSelf = self, case .completed = outcome {
+                let latency = CACurrentMediaTime() - issued
+                if warm {
+                    strongSelf.warmFirstLoads.record(latency)
+                } else {
+                    strongSelf.coldFirstLoads.record(latency)
+                }
+            }
+            completion?(outcome)
+        }
+    }
+
+    /// First-load latencies split by warm and cold, and the difference of
+    /// their medians.
+    func statistics() -> [String: Any] {
+        var saved: Double = 0
+        if warmFirstLoads.count > 0 && coldFirstLoads.count > 0 {
+            saved = (coldFirstLoads.value(atPercentile: 50) - warmFirstLoads.value(atPercentile: 50)) * 1000
+        }
+        return ["warm_first_load": warmFirstLoads.summary(), "cold_first_load": coldFirstLoads.summary(), "warm_up": warmUps.summary(), "p50_saved_ms": saved]
+    }
+
+    //MARK: GCKSessionManagerListener
+    func sessionManager(_ sessionManager: GCKSessionManager, willStart session: GCKCastSession) {
+        if isEnabled {
+            prepareCandidates()
+        }
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didStart session: GCKCastSession) {
+        isWarm = false
+        awaitingFirstLoad = true
+        if isEnabled {
+            warmUp()
+        }
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didEnd session: GCKCastSession, withError error: Error?) {
+        isWarm = false
+        awaitingFirstLoad = false
+    }
+}
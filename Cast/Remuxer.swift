@@ -0,0 +1,87 @@
+//
+//  Remuxer.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+
+/// Repackages an FLV, MPEG-TS or AVI byte stream as fragmented MP4 while it
+/// downloads, without touching the H.264 and AAC inside.
+///
+/// The container is recognised from its first bytes. Memory is what the
+/// demuxer needs for one frame plus one fragment of output. Not thread safe;
+/// feed it from one queue.
+final class Remuxer {
+
+    /// MIME types of the containers that can be remuxed. WMV carries VC-1 and
+    /// WMA, which would need re-encoding, so it is not among them.
+    static let contentTypes: Set<String> = ["video/x-flv", "video/x-msvideo", "video/avi", "video/mp2t"]
+
+    //MARK: Properties
+    private var demuxer: MediaDemuxer?
+    private let writer = FragmentedMP4Writer()
+    private var sniffed: [UInt8] = []
+    private var startedAt: CFTimeInterval?
+    private var detectionFailed = false
+    /// From the first byte in to the first fragment out.
+    private(set) var timeToFirstFragment: TimeInterval?
+
+    var failure: String? {
+        return detectionFailed ? "unrecognised container" : writer.failure
+    }
+
+    //MARK: Methods
+    static func canRemux(contentType: String) -> Bool {
+        return contentTypes.contains(contentType.lowercased())
+    }
+
+    func append(_ data: Data) -> [UInt8] {
+        startedAt = startedAt ?? CACurrentMediaTime()
+        if let demuxer = demuxer {
+            return written(writer.write(demuxer.append(data)))
+        }
+        sniffed.append(contentsOf: data)
+        guard let detected = detect() else {
+            return []
+        }
+        demuxer = detected
+        let pending = Data(bytes: sniffed)
+        sniffed = []
+        return written(writer.write(detected.append(pending)))
+    }
+
+    func finish() -> [UInt8] {
+        guard let demuxer = demuxer else {
+            return []
+        }
+        return written(writer.write(demuxer.finish()) + writer.finish())
+    }
+
+    private func written(_ output: [UInt8]) -> [UInt8] {
+        if timeToFirstFragment == nil && writer.fragmentsWritten > 0, let startedAt = startedAt {
+            timeToFirstFragment = CACurrentMediaTime() - startedAt
+        }
+        return output
+    }
+
+    /// The demuxer for the container, once enough has arrived to tell.
+    private func detect() -> MediaDemuxer? {
+        if sniffed.count >= 3 && sniffed[0] == 0x46 && sniffed[1] == 0x4c && sniffed[2] == 0x56 {
+            return FLVDemuxer()
+        }
+        if sniffed.count >= 12 && Bytes.fourCC(sniffed, 0) == "RIFF" && Bytes.fourCC(sniffed, 8) == "AVI " {
+            return AVIDemuxer()
+        }
+        if sniffed.count > 188 {
+            if sniffed[0] == 0x47 && sniffed[188] == 0x47 {
+                return TSDemuxer()
+            }
+            detectionFailed = true
+        }
+        return nil
+    }
+}
@@ -0,0 +1,164 @@
+//
+//  SeekEngine.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+import GoogleCast
+
+/// Turns a drag across the position slider into as few receiver seeks as
+/// possible.
+///
+/// Every seek makes the receiver flush its buffers, so sending one per
+/// slider event costs far more than the one seek the user wanted. Scrub
+/// positions are shown on the local clock immediately and only the latest
+/// is sent, once the finger rests for `debounceInterval` or lifts. Sending a
+/// seek cancels the tracking of any earlier one still in flight. For HLS
+/// video on demand the target is snapped to the nearest segment start, where
+/// the receiver can begin decoding without fetching the segment before it.
+final class SeekEngine {
+
+    static let shared = SeekEngine()
+
+    //MARK: Properties
+    var debounceInterval: TimeInterval = 0.15
+    var snapsToSegments = true
+    /// Turn off to send every scrub event, for comparison.
+    var coalesces = true
+
+    private(set) var scrubEvents = 0
+    private(set) var seeksSent = 0
+    /// From lifting the finger to the receiver confirming the seek.
+    private(set) var perceivedLatencies = LatencyHistogram()
+
+    private var target: TimeInterval?
+    private var debounce: DispatchWorkItem?
+    private var releasedAt: CFTimeInterval?
+    private var segmentStarts: [TimeInterval] = []
+    private var segmentContentID: String?
+    private var subscription: MediaStatusSubscription?
+
+    //MARK: Lifecycle
+    func start() {
+        subscription = MediaStatusHub.shared.subscribe(.media) { [weak self] snapshot, _ in
+            self?.loadSegments(for: snapshot)
+        }
+    }
+
+    //MARK: Scrubbing
+
+    /// The slider moved to `position` and may move again.
+    func scrub(to position: TimeInterval) {
+        scrubEvents += 1
+        target = position
+        PlaybackClock.shared.hold(at: position)
+        if !coalesces {
+            sendLatest()
+            return
+        }
+        debounce?.cancel()
+        let work = DispatchWorkItem { [weak self] in
+            self?.sendLatest()
+        }
+        debounce = work
+        DispatchQueue.main.asyncAfter(deadline: .now() + debounceInterval, execute: work)
+    }
+
+    /// The finger lifted at `position`; seek there now.
+    func commit(to position: TimeInterval) {
+        scrubEvents += 1
+        target = position
+        releasedAt = CACurrentMediaTime()
+        PlaybackClock.shared.hold(at: position)
+        sendLatest()
+    }
+
+    private func sendLatest() {
+        debounce?.cancel()
+        debounce = nil
+        guard let target = target else {
+            return
+        }
+        self.target = nil
+
+        let position = snapped(target)
+        if position != target {
+            PlaybackClock.shared.hold(at: position)
+        }
+        CastRequestTracker.shared.cancel(.seek)
+        seeksSent += 1
+        CastRequestTracker.shared.issue(.seek, send: {
+            CastController.shared.remoteMediaClient?.seek(toTimeInterval: position)
+        }, completion: { [weak self] outcome in
+            if case .aborted = outcome {
+                // Superseded by a later seek, which will release the clock.
+                return
+            }
+            self?.seekDidFinish(outcome)
+        })
+    }
+
+    private func seekDidFinish(_ outcome: CastRequestOutcome) {
+        if target != nil || debounce != nil {
+            return
+        }
+        PlaybackClock.shared.release()
+        if case .completed = outcome, let releasedAt = releasedAt {
+            perceivedLatencies.record(CACurrentMediaTime() - releasedAt)
+        }
+        releasedAt = nil
+    }
+
+    //MARK: Snapping
+    private func snapped(_ position: TimeInterval) -> TimeInterval {
+        guard snapsToSegments, segmentContentID == MediaStatusHub.shared.snapshot.contentID, !segmentStarts.isEmpty else {
+            return position
+        }
+        // Binary search for the first start after the target, then take the closer neighbour.
+        var lower = 0
+        var upper = segmentStarts.count
+        while lower < upper {
+            let middle = (lower + upper) / 2
+            if segmentStarts[middle] <= position {
+                lower = middle + 1
+            } else {
+                upper = middle
+            }
+        }
+        let before = segmentStarts[max(0, lower - 1)]
+        guard lower < segmentStarts.count else {
+            return before
+        }
+        let after = segmentStarts[lower]
+        return position - before <= after - position ? before : after
+    }
+
+    private func loadSegments(for snapshot: MediaStatusSnapshot) {
+        guard let contentID = snapshot.contentID, contentID != segmentContentID else {
+            return
+        }
+        segmentContentID = contentID
+        segmentStarts = []
+        let type = (snapshot.contentType ?? "").lowercased()
+        guard let url = URL(string: contentID), type.contains("mpegurl") || url.pathExtension.lowercased() == "m3u8" else {
+            return
+        }
+        HLSPlaylist.load(url) { [weak self] playlist in
+            // A live or sliding playlist counts its segments from wherever its window is now, not from
+            // the receiver's stream position, and moves on; its starts would pull seeks to wrong targets.
+            guard let strongSelf = self, strongSelf.segmentContentID == contentID, let playlist = playlist, !playlist.isEndless else {
+                return
+            }
+            strongSelf.segmentStarts = playlist.segments.map { $0.start }
+        }
+    }
+
+    /// Scrub and seek counts plus perceived seek latency.
+    func statistics() -> [String: Any] {
+        return ["scrub_events": scrubEvents, "seeks_sent": seeksSent, "perceived": perceivedLatencies.summary()]
+    }
+}
@@ -0,0 +1,125 @@
+//
+//  SegmentCache.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// Media segments on disk, least recently used first out.
+///
+/// Files live in Caches, named by a hash of their URL, and the index is
+/// rebuilt from the directory at launch. Thread safe.
+final class SegmentCache {
+
+    static let shared = SegmentCache()
+
+    private struct Entry {
+        let size: Int
+        var lastUsed: Date
+    }
+
+    //MARK: Properties
+    /// Total size kept before the least recently used files go.
+    var capacity = 256 << 20
+    let directory: URL
+    private let lock = NSLock()
+    private var entries: [String: Entry] = [:]
+    private var totalSize = 0
+
+    //MARK: Lifecycle
+    init(directory: URL = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask)[0].appendingPathComponent("Segments")) {
+        self.directory = directory
+        try? FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true, attributes: nil)
+        let keys: [URLResourceKey] = [.fileSizeKey, .contentModificationDateKey]
+        let files = (try? FileManager.default.contentsOfDirectory(at: directory, includingPropertiesForKeys: keys, options: [])) ?? []
+        for file in files {
+            let values = try? file.resourceValues(forKeys: Set(keys))
+            let size = values?.fileSize ?? 0
+            entries[file.lastPathComponent] = Entry(size: size, lastUsed: values?.contentModificationDate ?? Date.distantPast)
+            totalSize += size
+        }
+    }
+
+    //MARK: Methods
+
+    /// The cached file for `url`, marked as just used, or nil.
+    func file(for url: URL) -> URL? {
+        let name = SegmentCache.name(for: url)
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        guard entries[name] != nil else {
+            return nil
+        }
+        entries[name]?.lastUsed = Date()
+        return directory.appendingPathComponent(name)
+    }
+
+    func contains(_ url: URL) -> Bool {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        return entries[SegmentCache.name(for: url)] != nil
+    }
+
+    /// Moves a downloaded file in as the copy of `url`, then trims the cache.
+    func insert(_ file: URL, for url: URL) {
+        let name = SegmentCache.name(for: url)
+        let destination = directory.appendingPathComponent(name)
+        try? FileManager.default.removeItem(at: destination)
+        guard (try? FileManager.default.moveItem(at: file, to: destination)) != nil else {
+            return
+        }
+        let size = ((try? FileManager.default.attributesOfItem(atPath: destination.path))?[.size] as? NSNumber)?.intValue ?? 0
+
+        lock.lock()
+        totalSize += size - (entries[name]?.size ?? 0)
+        entries[name] = Entry(size: size, lastUsed: Date())
+        var evicted: [String] = []
+        // Oldest first, never the file just added.
+        for (key, entry) in entries.sorted(by: { $0.value.lastUsed < $1.value.lastUsed }) where totalSize > capacity && key != name {
+            entries.removeValue(forKey: key)
+            totalSize -= entry.size
+            evicted.append(key)
+        }
+        lock.unlock()
+
+        for key in evicted {
+            try? FileManager.default.removeItem(at: directory.appendingPathComponent(key))
+        }
+    }
+
+    func removeAll() {
+        lock.lock()
+        let names = Array(entries.keys)
+        entries = [:]
+        totalSize = 0
+        lock.unlock()
+        for name in names {
+            try? FileManager.default.removeItem(at: directory.appendingPathComponent(name))
+        }
+    }
+
+    var size: Int {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        return totalSize
+    }
+
+    /// 64-bit FNV-1a of the URL, keeping its extension.
+    private static func name(for url: URL) -> String {
+        var hash: UInt64 = 0xcbf29ce484222325
+        for byte in url.absoluteString.utf8 {
+            hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+        }
+        let pathExtension = url.pathExtension.isEmpty ? "bin" : url.pathExtension
+        return String(format: "%016llx.", hash) + pathExtension
+    }
+}
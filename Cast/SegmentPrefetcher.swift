@@ -0,0 +1,238 @@
+//
+//  SegmentPrefetcher.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+import GoogleCast
+
+/// Reads ahead of the receiver through HLS media playlists.
+///
+/// Every media playlist the proxy relays is registered here. When the
+/// receiver asks for a segment, the next `readAhead` are downloaded from
+/// the origin into `SegmentCache`, so on a slow CDN the receiver is served
+/// from the phone instead of waiting. Thread safe; the proxy calls in from
+/// its own queues.
+final class SegmentPrefetcher {
+
+    static let shared = SegmentPrefetcher()
+
+    /// Where a requested segment can be had from.
+    enum Availability {
+        case cached(URL)
+        /// Still downloading; the waiter gets the file once it lands, or nil if the download failed.
+        case downloading
+        case missing
+    }
+
+    private struct Position {
+        let playlist: URL
+        let index: Int
+    }
+
+    //MARK: Properties
+    var isEnabled = true
+    /// Segments kept downloaded ahead of the last one requested.
+    var readAhead = 3
+    var maximumConcurrentDownloads = 2
+    let cache: SegmentCache
+
+    private let lock = NSLock()
+    private var playlists: [URL: (segments: [URL], referer: String)] = [:]
+    private var positions: [URL: Position] = [:]
+    private var queued: [(url: URL, referer: String)] = []
+    private var downloading = Set<URL>()
+    private var waiters: [URL: [(URL?) -> Void]] = [:]
+    private lazy var session: URLSession = {
+        let configuration = URLSessionConfiguration.default
+        configuration.urlCache = nil
+        configuration.requestCachePolicy = .reloadIgnoringLocalCacheData
+        return URLSession(configuration: configuration)
+    }()
+
+    // Main thread only.
+    private(set) var hits = 0
+    private(set) var misses = 0
+    /// Requests for a segment that was still downloading, answered from that download.
+    private(set) var joins = 0
+    /// From the receiver's request to the first byte going back, per source.
+    private(set) var hitLatencies = LatencyHistogram()
+    private(set) var missLatencies = LatencyHistogram()
+    private(set) var joinLatencies = LatencyHistogram()
+    private(set) var rebuffers = 0
+    private var subscription: MediaStatusSubscription?
+    private var lastPlayerState = GCKMediaPlayerState.unknown
+
+    //MARK: Lifecycle
+    init(cache: SegmentCache = .shared) {
+        self.cache = cache
+    }
+
+    /// Starts counting rebuffers: a drop from playing into buffering.
+    func start() {
+        subscription = MediaStatusHub.shared.subscribe([.playerState]) { [weak self] snapshot, _ in
+            guard let strongSelf = self else {
+                return
+            }
+            if strongSelf.lastPlayerState == .playing && snapshot.playerState == .buffering {
+                strongSelf.rebuffers += 1
+            }
+            strongSelf.lastPlayerState = snapshot.playerState
+        }
+    }
+
+    //MARK: Playlists
+
+    /// Remembers the segments of a media playlist the receiver has been
+    /// given and prefetches where it will start.
+    func register(segments: [URL], isLive: Bool, playlist url: URL, referer: String) {
+        guard isEnabled, !segments.isEmpty else {
+            return
+        }
+        lock.lock()
+        let isRefresh = playlists[url] != nil
+        if let previous = playlists[url] {
+            for segment in previous.segments {
+                positions.removeValue(forKey: segment)
+            }
+        }
+        playlists[url] = (segments, referer)
+        for (index, segment) in segments.enumerated() {
+            positions[segment] = Position(playlist: url, index: index)
+        }
+        lock.unlock()
+
+        if !isRefresh {
+            // Players start at the top of a video and near the end of a live stream.
+            let first = isLive ? max(segments.count - readAhead, 0) : 0
+            prefetch(segments[first..<min(first + readAhead, segments.count)], referer: referer)
+        }
+    }
+
+    /// The cached copy of `url` if it is a known segment that has been
+    /// prefetched. If it is still being prefetched, `whenDownloaded` is
+    /// called with the copy once it lands, on an arbitrary queue, so the
+    /// origin is not asked for it twice. Either way the segments after it
+    /// are prefetched.
+    func cachedFile(for url: URL, whenDownloaded: @escaping (URL?) -> Void) -> Availability {
+        guard isEnabled else {
+            return .missing
+        }
+        lock.lock()
+        let position = positions[url]
+        let playlist = position.flatMap { playlists[$0.playlist] }
+        let joined = position != nil && downloading.contains(url)
+        if joined {
+            waiters[url] = (waiters[url] ?? []) + [whenDownloaded]
+        } else {
+            // Fetched for the receiver now, either from the cache or the origin; not again later.
+            queued = queued.filter { $0.url != url }
+        }
+        lock.unlock()
+        guard let found = position, let segments = playlist?.segments, let referer = playlist?.referer else {
+            return .missing
+        }
+        let next = found.index + 1
+        prefetch(segments[min(next, segments.count)..<min(next + readAhead, segments.count)], referer: referer)
+        // A download that finished since is in the cache already: it is inserted before it stops counting as downloading.
+        let file = joined ? nil : cache.file(for: url)
+        DispatchQueue.main.async {
+            if joined {
+                self.joins += 1
+            } else if file != nil {
+                self.hits += 1
+            } else {
+                self.misses += 1
+            }
+        }
+        if joined {
+            return .downloading
+        }
+        return file.map { .cached($0) } ?? .missing
+    }
+
+    /// Whether `url` is a segment of a registered playlist.
+    func isSegment(_ url: URL) -> Bool {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        return isEnabled && positions[url] != nil
+    }
+
+    func recordLatency(_ latency: TimeInterval, hit: Bool) {
+        DispatchQueue.main.async {
+            if hit {
+                self.hitLatencies.record(latency)
+            } else {
+                self.missLatencies.record(latency)
+            }
+        }
+    }
+
+    func recordJoinLatency(_ latency: TimeInterval) {
+        DispatchQueue.main.async {
+            self.joinLatencies.record(latency)
+        }
+    }
+
+    //MARK: Downloads
+    private func prefetch(_ segments: ArraySlice<URL>, referer: String) {
+        lock.lock()
+        for url in segments where !downloading.contains(url) && !queued.contains(where: { $0.url == url }) && !cache.contains(url) {
+            queued.append((url, referer))
+        }
+        lock.unlock()
+        startDownloads()
+    }
+
+    private func startDownloads() {
+        lock.lock()
+        var started: [(url: URL, referer: String)] = []
+        while downloading.count < maximumConcurrentDownloads && !queued.isEmpty {
+            let next = queued.removeFirst()
+            downloading.insert(next.url)
+            started.append(next)
+        }
+        lock.unlock()
+
+        for (url, referer) in started {
+            let startedAt = CACurrentMediaTime()
+            session.downloadTask(with: MediaProxy.shared.request(for: url, referer: referer)) { file, response, _ in
+                let status = (response as? HTTPURLResponse)?.statusCode ?? 0
+                if let file = file, status >= 200 && status < 300 {
+                    let size = ((try? FileManager.default.attributesOfItem(atPath: file.path))?[.size] as? NSNumber)?.intValue ?? 0
+                    VariantPolicy.shared.recordTransfer(bytes: size, seconds: CACurrentMediaTime() - startedAt)
+                    self.cache.insert(file, for: url)
+                }
+                self.lock.lock()
+                self.downloading.remove(url)
+                let waiting = self.waiters.removeValue(forKey: url) ?? []
+                self.lock.unlock()
+                if !waiting.isEmpty {
+                    let cached = self.cache.file(for: url)
+                    for waiter in waiting {
+                        waiter(cached)
+                    }
+                }
+                self.startDownloads()
+            }.resume()
+        }
+    }
+
+    //MARK: Statistics
+    func statistics() -> [String: Any] {
+        return ["hits": hits,
+                "misses": misses,
+                "joins": joins,
+                "hit_latency": hitLatencies.summary(),
+                "miss_latency": missLatencies.summary(),
+                "join_latency": joinLatencies.summary(),
+                "rebuffers": rebuffers,
+                "cache_bytes": cache.size]
+    }
+}
@@ -0,0 +1,253 @@
+//
+//  SessionResumer.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import QuartzCore
+import GoogleCast
+
+/// Gets the user back to controlling what they were casting after the app
+/// is relaunched.
+///
+/// The device, the receiver application session and a snapshot of the media
+/// status are saved whenever they change. On launch the snapshot is
+/// published through `MediaStatusHub` right away, then the SDK's own
+/// session resume is raced against discovery finding the saved device,
+/// whichever connects to it first wins. If the receiver turns out to be
+/// idle, the saved media is loaded again at its saved position.
+final class SessionResumer: NSObject, GCKSessionManagerListener {
+
+    static let shared = SessionResumer()
+    private static let defaultsKey = "SessionResumerState"
+
+    enum Path: String {
+        case sdkResume
+        case discovery
+    }
+
+    //MARK: Properties
+    /// Saved state older than this is not worth resuming.
+    var maximumAge: TimeInterval = 6 * 60 * 60
+    /// How long to keep racing before leaving the user to reconnect.
+    var timeout: TimeInterval = 15
+
+    private(set) var timeToControllable: TimeInterval?
+    private(set) var winningPath: Path?
+    private(set) var resumedSameSession = false
+
+    private var saved: [String: Any]?
+    private var launchedAt: CFTimeInterval = 0
+    private var racing = false
+    private var sdkResuming = false
+    private var startedFromDiscovery = false
+    private var awaitingControl = false
+    private var subscription: MediaStatusSubscription?
+    private var discoverySubscription: DiscoverySubscription?
+
+    private var sessionManager: GCKSessionManager {
+        return GCKCastContext.sharedInstance().sessionManager
+    }
+
+    private var discoveryManager: GCKDiscoveryManager {
+        return GCKCastContext.sharedInstance().discoveryManager
+    }
+
+    //MARK: Lifecycle
+
+    /// Restores the saved state and starts the race. `launchedAt` is the
+    /// `CACurrentMediaTime()` the time to controllable is measured from.
+    func start(launchedAt: CFTimeInterval) {
+        self.launchedAt = launchedAt
+        sessionManager.add(self)
+        subscription = MediaStatusHub.shared.subscribe([.playerState, .media, .metadata]) { [weak self] snapshot, _ in
+            self?.statusDidChange(snapshot)
+        }
+
+        guard let state = UserDefaults.standard.dictionary(forKey: SessionResumer.defaultsKey),
+            let savedAt = state["savedAt"] as? Date, Date().timeIntervalSince(savedAt) < maximumAge,
+            state["deviceID"] is String else {
+            return
+        }
+        saved = state
+        MediaStatusHub.shared.restore(SessionResumer.snapshot(from: state))
+
+        racing = true
+        sdkResuming = sessionManager.connectionState == .connecting
+        discoverySubscription = DiscoveryBatcher.shared.subscribe { [weak self] _ in
+            self?.tryDiscoveredDevice()
+        }
+        DispatchQueue.main.asyncAfter(deadline: .now() + timeout) { [weak self] in
+            self?.stopRacing()
+        }
+    }
+
+    private func stopRacing() {
+        if racing {
+            racing = false
+            discoverySubscription = nil
+        }
+    }
+
+    //MARK: Racing
+    private func tryDiscoveredDevice() {
+        guard racing, !sdkResuming, sessionManager.connectionState == .disconnected,
+            let deviceID = saved?["deviceID"] as? String,
+            // A remembered device can be connected to before discovery has found it again.
+            let device = discoveryManager.device(withUniqueID: deviceID) ?? DeviceCache.shared.device(withUniqueID: deviceID) else {
+            return
+        }
+        startedFromDiscovery = sessionManager.startSession(with: device)
+    }
+
+    private func sessionDidConnect(_ session: GCKCastSession, path: Path) {
+        // The user picking another TV meanwhile ends the race without winning it.
+        if racing && session.device.uniqueID == saved?["deviceID"] as? String {
+            winningPath = path
+            resumedSameSession = session.sessionID != nil && session.sessionID == saved?["sessionID"] as? String
+            awaitingControl = true
+        }
+        stopRacing()
+        save(session: session)
+        statusDidChange(MediaStatusHub.shared.snapshot)
+    }
+
+    /// The session counts as controllable once the receiver has sent its
+    /// first media status over it.
+    private func statusDidChange(_ snapshot: MediaStatusSnapshot) {
+        guard let client = CastController.shared.remoteMediaClient else {
+            return
+        }
+        if awaitingControl, client.mediaStatus != nil {
+            awaitingControl = false
+            timeToControllable = CACurrentMediaTime() - launchedAt
+            reloadIfIdle(snapshot)
+        }
+        if client.mediaStatus != nil {
+            save(snapshot: snapshot)
+        }
+    }
+
+    private func reloadIfIdle(_ snapshot: MediaStatusSnapshot) {
+        guard snapshot.playerState == .idle || snapshot.playerState == .unknown,
+            let state = saved, let contentID = state["contentID"] as? String,
+            let rawState = state["playerState"] as? Int, let savedAt = state["savedAt"] as? Date else {
+            return
+        }
+        let playerState = GCKMediaPlayerState(rawValue: rawState) ?? .unknown
+        if playerState != .playing && playerState != .paused && playerState != .buffering {
+            return
+        }
+        var position = state["position"] as? Double ?? 0
+        if playerState == .playing {
+            position += Date().timeIntervalSince(savedAt)
+        }
+        let duration = state["duration"] as? Double ?? 0
+        if duration > 0 && position >= duration {
+            return
+        }
+
+        let metadata = GCKMediaMetadata(metadataType: .generic)
+        metadata.setString(state["title"] as? String ?? contentID, forKey: kGCKMetadataKeyTitle)
+        let information = GCKMediaInformation(contentID: contentID, streamType: .unknown, contentType: state["contentType"] as? String ?? "", metadata: metadata, streamDuration: duration, customData: nil)
+        CastController.shared.load(information, autoplay: playerState != .paused, playPosition: position)
+    }
+
+    //MARK: Persisting
+    private func save(session: GCKCastSession) {
+        var state = UserDefaults.standard.dictionary(forKey: SessionResumer.defaultsKey) ?? [:]
+        if state["deviceID"] as? String != session.device.uniqueID {
+            state = [:]
+        }
+        state["deviceID"] = session.device.uniqueID
+        state["sessionID"] = session.sessionID
+        state["savedAt"] = Date()
+        UserDefaults.standard.set(state, forKey: SessionResumer.defaultsKey)
+    }
+
+    private func save(snapshot: MediaStatusSnapshot) {
+        guard var state = UserDefaults.standard.dictionary(forKey: SessionResumer.defaultsKey) else {
+            return
+        }
+        state["contentID"] = snapshot.contentID
+        state["contentType"] = snapshot.contentType
+        state["title"] = snapshot.title
+        state["duration"] = snapshot.streamDuration
+        state["playerState"] = snapshot.playerState.rawValue
+        state["position"] = PlaybackClock.shared.position()
+        state["savedAt"] = Date()
+        UserDefaults.standard.set(state, forKey: SessionResumer.defaultsKey)
+    }
+
+    /// Saves the current position, which otherwise is only written when the
+    /// player state or media changes. Call when the app goes to the background.
+    func savePosition() {
+        if CastController.shared.remoteMediaClient?.mediaStatus != nil {
+            save(snapshot: MediaStatusHub.shared.snapshot)
+        }
+    }
+
+    private func clear() {
+        UserDefaults.standard.removeObject(forKey: SessionResumer.defaultsKey)
+        saved = nil
+    }
+
+    private static func snapshot(from state: [String: Any]) -> MediaStatusSnapshot {
+        var snapshot = MediaStatusSnapshot()
+        snapshot.contentID = state["contentID"] as? String
+        snapshot.contentType = state["contentType"] as? String
+        snapshot.title = state["title"] as? String
+        snapshot.streamDuration = state["duration"] as? Double ?? 0
+        snapshot.streamPosition = state["position"] as? Double ?? 0
+        snapshot.playerState = GCKMediaPlayerState(rawValue: state["playerState"] as? Int ?? 0) ?? .unknown
+        snapshot.playbackRate = snapshot.playerState == .playing ? 1 : 0
+        // Back-date the arrival so the clock carries a playing item forward by the time the app was away.
+        let age = Date().timeIntervalSince(state["savedAt"] as? Date ?? Date())
+        snapshot.receivedAt = CACurrentMediaTime() - max(0, age)
+        return snapshot
+    }
+
+    //MARK: Statistics
+
+    /// How this launch got back to the saved session, once it has.
+    func statistics() -> [String: Any] {
+        var statistics: [String: Any] = ["resumed_same_session": resumedSameSession]
+        statistics["time_to_controllable_ms"] = timeToControllable.map { $0 * 1000 }
+        statistics["winning_path"] = winningPath?.rawValue
+        return statistics
+    }
+
+    //MARK: GCKSessionManagerListener
+    func sessionManager(_ sessionManager: GCKSessionManager, willResumeCastSession session: GCKCastSession) {
+        sdkResuming = true
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didResumeCastSession session: GCKCastSession) {
+        sdkResuming = false
+        sessionDidConnect(session, path: .sdkResume)
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didStart session: GCKCastSession) {
+        sessionDidConnect(session, path: startedFromDiscovery ? .discovery : .sdkResume)
+        startedFromDiscovery = false
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didFailToStart session: GCKCastSession, withError error: Error) {
+        startedFromDiscovery = false
+        tryDiscoveredDevice()
+    }
+
+    func sessionManager(_ sessionManager: GCKSessionManager, didEnd session: GCKCastSession, withError error: Error?) {
+        if sdkResuming {
+            // The SDK could not get the old session back; let discovery have a go.
+            sdkResuming = false
+            tryDiscoveredDevice()
+        } else if error == nil {
+            // Ended on purpose, nothing to come back to.
+            clear()
+        }
+    }
+}
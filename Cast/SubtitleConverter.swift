@@ -0,0 +1,189 @@
+//
+//  SubtitleConverter.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// Turns SubRip or SubStation Alpha subtitles into WebVTT as they download.
+///
+/// Works a line at a time. SubRip only needs its timestamps respelled.
+/// SubStation `Dialogue` lines become cues in file order, with their style
+/// overrides dropped. WebVTT passes through. Not thread safe; feed it from one queue.
+final class SubtitleConverter {
+
+    enum Format {
+        case webVTT
+        case subRip
+        case subStationAlpha
+    }
+
+    //MARK: Properties
+    let format: Format
+    private var pending: [UInt8] = []
+    private var output = Data()
+    private var startedOutput = false
+    // SubStation Alpha
+    private var inEvents = false
+    private var fields = ["Layer", "Start", "End", "Style", "Name", "MarginL", "MarginR", "MarginV", "Effect", "Text"]
+
+    //MARK: Lifecycle
+    init(format: Format) {
+        self.format = format
+    }
+
+    static func format(of url: URL) -> Format {
+        switch url.pathExtension.lowercased() {
+        case "srt":
+            return .subRip
+        case "ass", "ssa":
+            return .subStationAlpha
+        default:
+            return .webVTT
+        }
+    }
+
+    /// The subtitle types the converter reads, by extension.
+    static let pathExtensions: Set<String> = ["vtt", "srt", "ass", "ssa"]
+
+    //MARK: Methods
+    func append(_ data: Data) -> Data {
+        if format == .webVTT {
+            return data
+        }
+        pending.append(contentsOf: data)
+        var start = 0
+        for (index, byte) in pending.enumerated() where byte == 0x0a {
+            line(Array(pending[start..<index]))
+            start = index + 1
+        }
+        pending.removeFirst(start)
+        return takeOutput()
+    }
+
+    func finish() -> Data {
+        if format == .webVTT {
+            return Data()
+        }
+        if !pending.isEmpty {
+            line(pending)
+            pending = []
+        }
+        if !startedOutput {
+            emit("WEBVTT\n\n")
+        }
+        return takeOutput()
+    }
+
+    private func emit(_ text: String) {
+        output.append(text.data(using: .utf8) ?? Data())
+    }
+
+    private func takeOutput() -> Data {
+        defer {
+            output = Data()
+        }
+        return output
+    }
+
+    private func line(_ bytes: [UInt8]) {
+        var bytes = bytes
+        if !startedOutput {
+            startedOutput = true
+            emit("WEBVTT\n\n")
+            if bytes.starts(with: [0xef, 0xbb, 0xbf]) {
+                bytes.removeFirst(3)
+            }
+        }
+        // Older files are often Latin-1 rather than UTF-8.
+        let text = (String(bytes: bytes, encoding: .utf8) ?? String(bytes: bytes, encoding: .isoLatin1) ?? "").trimmingCharacters(in: CharacterSet(charactersIn: "\r"))
+        switch format {
+        case .subRip:
+            subRipLine(text)
+        case .subStationAlpha:
+            subStationLine(text)
+        case .webVTT:
+            break
+        }
+    }
+
+    //MARK: SubRip
+
+    /// `00:00:01,500 --> 00:00:03,000 X1:…` becomes `00:00:01.500 --> 00:00:03.000`.
+    private func subRipLine(_ line: String) {
+        let times = line.components(separatedBy: "-->")
+        guard times.count == 2 else {
+            emit(SubtitleConverter.strippingOverrides(line) + "\n")
+            return
+        }
+        let start = times[0].trimmingCharacters(in: .whitespaces).replacingOccurrences(of: ",", with: ".")
+        let end = (times[1].trimmingCharacters(in: .whitespaces).components(separatedBy: " ").first ?? "").replacingOccurrences(of: ",", with: ".")
+        emit(start + " --> " + end + "\n")
+    }
+
+    //MARK: SubStation Alpha
+    private func subStationLine(_ line: String) {
+        if line.hasPrefix("[") {
+            inEvents = line.lowercased() == "[events]"
+            return
+        }
+        guard inEvents, let colon = line.range(of: ":") else {
+            return
+        }
+        let key = line.substring(to: colon.lowerBound)
+        let value = line.substring(from: colon.upperBound)
+        if key == "Format" {
+            fields = value.components(separatedBy: ",").map { $0.trimmingCharacters(in: .whitespaces) }
+            return
+        }
+        guard key == "Dialogue", let startIndex = fields.index(of: "Start"), let endIndex = fields.index(of: "End"), let textIndex = fields.index(of: "Text") else {
+            return
+        }
+        // The text is last and may itself contain commas.
+        let values = value.characters.split(separator: ",", maxSplits: fields.count - 1, omittingEmptySubsequences: false).map { String($0).trimmingCharacters(in: .whitespaces) }
+        guard values.count == fields.count, let start = SubtitleConverter.time(values[startIndex]), let end = SubtitleConverter.time(values[endIndex]) else {
+            return
+        }
+        var text = SubtitleConverter.strippingOverrides(values[textIndex])
+            .replacingOccurrences(of: "&", with: "&amp;")
+            .replacingOccurrences(of: "<", with: "&lt;")
+            .replacingOccurrences(of: ">", with: "&gt;")
+            .replacingOccurrences(of: "\\N", with: "\n")
+            .replacingOccurrences(of: "\\n", with: "\n")
+            .replacingOccurrences(of: "\\h", with: " ")
+        // A blank line would end the cue early.
+        while text.contains("\n\n") {
+            text = text.replacingOccurrences(of: "\n\n", with: "\n")
+        }
+        emit(start + " --> " + end + "\n" + text + "\n\n")
+    }
+
+    /// `h:mm:ss.cc` as `hh:mm:ss.mmm`.
+    private static func time(_ value: String) -> String? {
+        let parts = value.components(separatedBy: ":")
+        guard parts.count == 3, let hours = Int(parts[0]), let minutes = Int(parts[1]), let seconds = Double(parts[2]) else {
+            return nil
+        }
+        let milliseconds = Int((seconds * 1000).rounded())
+        return String(format: "%02d:%02d:%02d.%03d", hours, minutes, milliseconds / 1000, milliseconds % 1000)
+    }
+
+    /// Without `{…}` override blocks, which WebVTT would show as text.
+    private static func strippingOverrides(_ text: String) -> String {
+        var result = ""
+        var depth = 0
+        for character in text.characters {
+            if character == "{" {
+                depth += 1
+            } else if character == "}" && depth > 0 {
+                depth -= 1
+            } else if depth == 0 {
+                result.append(character)
+            }
+        }
+        return result
+    }
+}
@@ -0,0 +1,223 @@
+//
+//  TSDemuxer.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+
+/// Splits an MPEG transport stream into H.264 and AAC frames.
+///
+/// The first program's H.264 and ADTS AAC streams are followed. Video PES
+/// packets are converted from Annex B to length prefixes, with the first
+/// SPS and PPS making the `avcC` record, and ADTS headers are stripped from
+/// audio. Only the PES being assembled for each stream is held.
+final class TSDemuxer: MediaDemuxer {
+
+    private static let packetSize = 188
+
+    //MARK: Properties
+    private var buffer: [UInt8] = []
+    private var pmtPID: Int?
+    private var videoPID: Int?
+    private var audioPID: Int?
+    private var pes: [Int: [UInt8]] = [:]
+    private var sps: [UInt8]?
+    private var pps: [UInt8]?
+    private var videoConfigured = false
+    private var audioConfig: AudioConfig?
+
+    //MARK: MediaDemuxer
+    func append(_ data: Data) -> [DemuxEvent] {
+        buffer.append(contentsOf: data)
+        var events: [DemuxEvent] = []
+        var offset = 0
+        while offset + TSDemuxer.packetSize <= buffer.count {
+            guard buffer[offset] == 0x47 else {
+                // Lost sync; look for the next packet start.
+                offset += 1
+                continue
+            }
+            events += packet(at: offset)
+            offset += TSDemuxer.packetSize
+        }
+        buffer.removeFirst(offset)
+        return events
+    }
+
+    /// Pushes out the PES packets still being assembled.
+    func finish() -> [DemuxEvent] {
+        var events: [DemuxEvent] = []
+        for (pid, bytes) in pes {
+            events += elementaryStream(pid, bytes)
+        }
+        pes = [:]
+        return events
+    }
+
+    //MARK: Packets
+    private func packet(at offset: Int) -> [DemuxEvent] {
+        let unitStart = buffer[offset + 1] & 0x40 != 0
+        let pid = Int(buffer[offset + 1] & 0x1f) << 8 | Int(buffer[offset + 2])
+        let adaptation = buffer[offset + 3] >> 4 & 0x03
+        var payload = offset + 4
+        if adaptation & 0x02 != 0 {
+            payload += 1 + Int(buffer[offset + 4])
+        }
+        let end = offset + TSDemuxer.packetSize
+        guard adaptation & 0x01 != 0, payload < end else {
+            return []
+        }
+
+        if pid == 0 || pid == pmtPID {
+            // Sections start after a pointer field.
+            guard unitStart else {
+                return []
+            }
+            let section = payload + 1 + Int(buffer[payload])
+            return section < end ? table(Array(buffer[section..<end]), pid: pid) : []
+        }
+        guard pid == videoPID || pid == audioPID else {
+            return []
+        }
+        var events: [DemuxEvent] = []
+        if unitStart, let previous = pes[pid] {
+            events = elementaryStream(pid, previous)
+            pes[pid] = nil
+        }
+        if unitStart || pes[pid] != nil {
+            // Taken out while appending so the array is not copied.
+            var bytes = pes.removeValue(forKey: pid) ?? []
+            bytes += buffer[payload..<end]
+            pes[pid] = bytes
+        }
+        return events
+    }
+
+    private func table(_ section: [UInt8], pid: Int) -> [DemuxEvent] {
+        guard section.count > 8 else {
+            return []
+        }
+        let length = min(Int(section[1] & 0x0f) << 8 | Int(section[2]), section.count - 3)
+        // Everything after the header up to the CRC.
+        let end = 3 + length - 4
+        if pid == 0 {
+            var index = 8
+            while index + 4 <= end {
+                let program = Bytes.uint16(section, index)
+                if program != 0 {
+                    pmtPID = Bytes.uint16(section, index + 2) & 0x1fff
+                    break
+                }
+                index += 4
+            }
+            return []
+        }
+        guard videoPID == nil && audioPID == nil, section.count > 12 else {
+            return []
+        }
+        var index = 12 + (Bytes.uint16(section, 10) & 0x0fff)
+        var unsupported: [String] = []
+        while index + 5 <= end {
+            let streamType = section[index]
+            let streamPID = Bytes.uint16(section, index + 1) & 0x1fff
+            switch streamType {
+            case 0x1b where videoPID == nil:
+                videoPID = streamPID
+            case 0x0f where audioPID == nil:
+                audioPID = streamPID
+            case 0x02, 0x24, 0x03, 0x04, 0x81:
+                unsupported.append(String(format: "stream type 0x%02x", streamType))
+            default:
+                break
+            }
+            index += 5 + (Bytes.uint16(section, index + 3) & 0x0fff)
+        }
+        if videoPID == nil && audioPID == nil {
+            return [.unsupported(unsupported.isEmpty ? "no H.264 or AAC streams" : unsupported.joined(separator: ", "))]
+        }
+        return [.tracks(video: videoPID != nil, audio: audioPID != nil)]
+    }
+
+    //MARK: Elementary streams
+    private func elementaryStream(_ pid: Int, _ bytes: [UInt8]) -> [DemuxEvent] {
+        guard bytes.count > 9, bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 1 else {
+            return []
+        }
+        let flags = bytes[7] >> 6
+        let headerLength = Int(bytes[8])
+        let headerEnd = 9 + headerLength
+        guard flags & 0x02 != 0 else {
+            return []
+        }
+        // PTS takes five header bytes, PTS and DTS ten.
+        guard headerLength >= (flags == 0x03 ? 10 : 5), headerEnd <= bytes.count else {
+            return [.unsupported("malformed PES header")]
+        }
+        if headerEnd == bytes.count {
+            return []
+        }
+        let pts = TSDemuxer.timestamp(bytes, 9)
+        let dts = flags == 0x03 ? TSDemuxer.timestamp(bytes, 14) : pts
+        let payload = Array(bytes[headerEnd..<bytes.count])
+        return pid == videoPID ? video(payload, pts: pts, dts: dts) : audio(payload, pts: pts)
+    }
+
+    private func video(_ payload: [UInt8], pts: Int64, dts: Int64) -> [DemuxEvent] {
+        var events: [DemuxEvent] = []
+        var units: [ArraySlice<UInt8>] = []
+        var keyframe = false
+        for unit in H264.nalUnits(inAnnexB: payload) {
+            switch H264.type(of: unit) {
+            case 7:
+                sps = sps ?? Array(unit)
+            case 8:
+                pps = pps ?? Array(unit)
+            case 9:
+                // Access unit delimiters mean nothing inside MP4.
+                break
+            case 5:
+                keyframe = true
+                units.append(unit)
+            default:
+                units.append(unit)
+            }
+        }
+        if !videoConfigured, let sps = sps, let pps = pps {
+            videoConfigured = true
+            guard let avcC = H264.decoderConfiguration(sps: sps, pps: pps) else {
+                return [.unsupported("malformed H.264 parameter sets")]
+            }
+            let size = H264.dimensions(ofSequenceParameterSet: sps)
+            events.append(.videoConfig(VideoConfig(avcC: avcC, width: size?.width ?? 0, height: size?.height ?? 0)))
+        }
+        if !units.isEmpty {
+            events.append(.sample(MediaSample(isVideo: true, data: H264.lengthPrefixed(units), decodeTime: dts, compositionOffset: max(pts - dts, 0), isKeyframe: keyframe)))
+        }
+        return events
+    }
+
+    private func audio(_ payload: [UInt8], pts: Int64) -> [DemuxEvent] {
+        let (config, frames) = AAC.frames(inADTS: payload)
+        var events: [DemuxEvent] = []
+        if audioConfig == nil, let config = config {
+            audioConfig = config
+            events.append(.audioConfig(config))
+        }
+        let frameTicks = Int64(1024 * 90000 / (audioConfig?.sampleRate ?? 44100))
+        for (index, frame) in frames.enumerated() {
+            events.append(.sample(MediaSample(isVideo: false, data: frame, decodeTime: pts + Int64(index) * frameTicks, compositionOffset: 0, isKeyframe: true)))
+        }
+        return events
+    }
+
+    /// A 33-bit PTS or DTS in 90 kHz ticks.
+    private static func timestamp(_ bytes: [UInt8], _ at: Int) -> Int64 {
+        let high = Int64(bytes[at] >> 1 & 0x07) << 30
+        let middle = Int64(Bytes.uint16(bytes, at + 1) >> 1) << 15
+        let low = Int64(Bytes.uint16(bytes, at + 3) >> 1)
+        return high | middle | low
+    }
+}
@@ -0,0 +1,99 @@
+//
+//  VariantPolicy.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import Foundation
+import GoogleCast
+
+/// What the connected receiver can sustain, for pruning adaptive variants.
+///
+/// The resolution ceiling starts from the device model and is raised by the
+/// largest video the receiver has reported playing in its `GCKVideoInfo`.
+/// Bandwidth is a moving average of segment transfers through the proxy.
+/// Thread safe; the proxy reads `limits` from its own queues.
+final class VariantPolicy {
+
+    static let shared = VariantPolicy()
+
+    struct Limits {
+        var width: Int
+        var height: Int
+        /// Bits per second a variant may need; 0 when nothing has been measured.
+        var bandwidth: Int
+        /// Bits per second measured, for choosing where playback starts.
+        var measuredBandwidth: Int
+    }
+
+    //MARK: Properties
+    var isEnabled = true
+    /// Share of the measured bandwidth a variant may take.
+    var headroom = 0.8
+    /// Transfers smaller than this say more about latency than bandwidth.
+    var minimumSampleBytes = 128 << 10
+
+    private let lock = NSLock()
+    private var ceiling = (width: 1920, height: 1080)
+    private var reported = (width: 0, height: 0)
+    private var bandwidthEstimate = 0.0
+    private var subscription: MediaStatusSubscription?
+
+    //MARK: Lifecycle
+    func start() {
+        subscription = MediaStatusHub.shared.subscribe([.media, .videoInfo]) { [weak self] snapshot, fields in
+            guard let strongSelf = self else {
+                return
+            }
+            if fields.contains(.media) {
+                strongSelf.updateCeiling()
+            }
+            if snapshot.videoWidth > 0 && snapshot.videoHeight > 0 {
+                strongSelf.lock.lock()
+                strongSelf.reported = (max(strongSelf.reported.width, snapshot.videoWidth), max(strongSelf.reported.height, snapshot.videoHeight))
+                strongSelf.lock.unlock()
+            }
+        }
+    }
+
+    /// 4K for the models that output it, 1080p otherwise. A new device
+    /// forgets what the previous one reported.
+    private func updateCeiling() {
+        let model = GCKCastContext.sharedInstance().sessionManager.currentCastSession?.device.modelName?.lowercased() ?? ""
+        let uhd = ["ultra", "google tv", "android tv", "shield", "bravia"].contains { model.contains($0) }
+        lock.lock()
+        let changed = uhd != (ceiling.height > 1080)
+        ceiling = uhd ? (3840, 2160) : (1920, 1080)
+        if changed {
+            reported = (0, 0)
+        }
+        lock.unlock()
+    }
+
+    //MARK: Methods
+    var limits: Limits {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        guard isEnabled else {
+            return Limits(width: Int.max, height: Int.max, bandwidth: 0, measuredBandwidth: 0)
+        }
+        return Limits(width: max(ceiling.width, reported.width),
+                      height: max(ceiling.height, reported.height),
+                      bandwidth: Int(bandwidthEstimate * headroom),
+                      measuredBandwidth: Int(bandwidthEstimate))
+    }
+
+    func recordTransfer(bytes: Int, seconds: TimeInterval) {
+        guard bytes >= minimumSampleBytes && seconds > 0 else {
+            return
+        }
+        let sample = Double(bytes) * 8 / seconds
+        lock.lock()
+        bandwidthEstimate = bandwidthEstimate == 0 ? sample : bandwidthEstimate * 0.7 + sample * 0.3
+        lock.unlock()
+    }
+}
@@ -7,16 +7,27 @@
 //
 
 import UIKit
+import WebKit
 
-class ViewController: UIViewController, UIWebViewDelegate {
+class ViewController: UIViewController, WKNavigationDelegate {
     //MARK: Outlets
     @IBOutlet weak var searchBar: UITextField!
-    @IBOutlet weak var webView: UIWebView!
+    @IBOutlet weak var webViewContainer: UIView!
     @IBOutlet weak var cancelButton: UIButton!
     @IBOutlet weak var searchBarTrailingConstraint: NSLayoutConstraint!
-    
+
     //MARK: Properties
-    static var videoURLs: [String] = []
+    var webView: WKWebView!
+    private var navigationStartedAt: CFTimeInterval = 0
+
+    /// Everything the extractor needs from a page in one round trip to the
+    /// web content process: its title, the user agent, the sources of its
+    /// media elements, and `<track>` elements and links to subtitle files.
+    private static let extractScript = "(function(){" +
+        "var media=[].slice.call(document.querySelectorAll('video,embed')).map(function(e){var s=e.src;if(!s&&e.tagName=='VIDEO'){var c=e.querySelector('source[src]');s=c?c.src:'';}return s||'';});" +
+        "var subtitles=[].slice.call(document.querySelectorAll('video track[src], a[href]')).filter(function(e){return e.tagName=='TRACK'||/\\.(vtt|srt|ass|ssa)$/i.test(e.pathname);})" +
+        ".map(function(e){return e.tagName=='TRACK'?[e.src,e.srclang||'',e.label||'','1']:[e.href,'',(e.textContent||'').trim(),''];});" +
+        "return JSON.stringify({title:document.title,userAgent:navigator.userAgent,cookie:document.cookie,media:media,subtitles:subtitles});})()"
     
     //MARK: Methods
     override func viewDidLoad() {
@@ -24,7 +35,10 @@ class ViewController: UIViewController, UIWebViewDelegate {
         // Do any additional setup after loading the view, typically from a nib.
         cancelButton.layer.cornerRadius = 5
         cancelButton.isHidden = true
-        webView.delegate = self
+        webView = WKWebView(frame: webViewContainer.bounds, configuration: WebContentBlocker.shared.configuration())
+        webView.autoresizingMask = [.flexibleWidth, .flexibleHeight]
+        webView.navigationDelegate = self
+        webViewContainer.addSubview(webView)
 
     }
     
@@ -40,56 +54,54 @@ class ViewController: UIViewController, UIWebViewDelegate {
 
     }
     
-    func webViewDidFinishLoad(_ webView: UIWebView) {
-        ViewController.videoURLs = []
-        var videoTag = ""
-        var embedTag = ""
-        let htmlCode = webView.stringByEvaluatingJavaScript(from: "document.documentElement.outerHTML")
-        let htmlTags = htmlCode!.components(separatedBy: "\n") as [String]
-        for tag in htmlTags{
-            var videoURL = ""
-            if tag.contains("<video") {
-                videoTag = tag.substring(from: tag.range(of: "<video")!.lowerBound)
-                videoTag = videoTag.substring(to: (videoTag.range(of: ">")?.upperBound)!)
-                if videoTag.contains("src"){
-                    videoTag = tag.substring(from: tag.range(of: "src")!.upperBound)
-                    for x in videoTag.characters{
-                        if x == "\""{
-                            continue
-                        }else if x == "="{
-                            continue
-                        }else if x == ">"{
-                            break
-                        }else{
-                            videoURL.append(x)
-                        }
-                    }
-                }
-                if !ViewController.videoURLs.contains(videoURL){
-                    ViewController.videoURLs.append(videoURL)
-                }
+    //MARK: WKNavigationDelegate
+    func webView(_ webView: WKWebView, didStartProvisionalNavigation navigation: WKNavigation!) {
+        navigationStartedAt = CACurrentMediaTime()
+    }
+
+    func webView(_ webView: WKWebView, decidePolicyFor navigationResponse: WKNavigationResponse, decisionHandler: @escaping (WKNavigationResponsePolicy) -> Void) {
+        WebCookieBridge.shared.record(navigationResponse.response)
+        decisionHandler(.allow)
+    }
+
+    func webView(_ webView: WKWebView, didFinish navigation: WKNavigation!) {
+        let loadTime = CACurrentMediaTime() - navigationStartedAt
+        let pageURL = webView.url?.absoluteString ?? ""
+        webView.evaluateJavaScript(ViewController.extractScript) { result, _ in
+            guard let json = (result as? String)?.data(using: .utf8),
+                let page = (try? JSONSerialization.jsonObject(with: json)) as? [String: Any] else {
+                return
             }
-            if tag.contains("<embed") {
-                embedTag = tag.substring(from: tag.range(of: "<embed")!.lowerBound)
-                embedTag = embedTag.substring(to: (embedTag.range(of: ">")?.upperBound)!)
-                if embedTag.contains("src"){
-                    embedTag = tag.substring(from: tag.range(of: "src")!.upperBound)
-                    for x in embedTag.characters{
-                        if x == "\""{
-                            continue
-                        }else if x == "="{
-                            continue
-                        }else if x == ">"{
-                            break
-                        }else{
-                            videoURL.append(x)
-                        }
-                    }
-                }
-                if !ViewController.videoURLs.contains(videoURL){
-                    ViewController.videoURLs.append(videoURL)
-                }
+            WebContentBlocker.shared.recordPageLoad(loadTime, scannedBytes: json.count)
+            if MediaProxy.shared.userAgent == nil {
+                MediaProxy.shared.userAgent = page["userAgent"] as? String
             }
+            if let cookie = page["cookie"] as? String, let url = webView.url {
+                WebCookieBridge.shared.record(documentCookie: cookie, for: url)
+            }
+            let pageTitle = page["title"] as? String ?? ""
+            MediaLibrary.shared.addSubtitles(ViewController.subtitles(from: page["subtitles"] as? [[String]] ?? []), pageURL: pageURL)
+            var videoURLs: [String] = []
+            for videoURL in page["media"] as? [String] ?? [] where !videoURLs.contains(videoURL) {
+                videoURLs.append(videoURL)
+            }
+            for videoURL in videoURLs {
+                MediaLibrary.shared.add(url: videoURL, pageTitle: pageTitle, pageURL: pageURL)
+            }
+        }
+    }
+
+    /// `<track>` elements, and links to subtitle files next to the video.
+    private static func subtitles(from elements: [[String]]) -> [SubtitleTrack] {
+        return elements.flatMap { element -> SubtitleTrack? in
+            guard element.count == 4, let url = URL(string: element[0]) else {
+                return nil
+            }
+            let isTrack = element[3] == "1"
+            guard isTrack || SubtitleConverter.pathExtensions.contains(url.pathExtension.lowercased()) else {
+                return nil
+            }
+            return SubtitleTrack(url: element[0], language: element[1], label: element[2].isEmpty ? url.lastPathComponent : element[2])
         }
     }
     
@@ -117,12 +129,12 @@ class ViewController: UIViewController, UIWebViewDelegate {
             if UIApplication.shared.canOpenURL(url){
                 var request = URLRequest(url: url)
                 request.allowsCellularAccess = false
-                webView.loadRequest(request)
+                webView.load(request)
             }else{
                 let googleSearchURL = URL(string: "https://www.google.com/search?client=safari&q=\(url)&ie=UTF-8&oe=UTF-8")
                 var request = URLRequest(url: googleSearchURL!)
                 request.allowsCellularAccess = false
-                webView.loadRequest(request)
+                webView.load(request)
             }
         }else{
             var searchString: [String] = []
@@ -149,10 +161,14 @@ class ViewController: UIViewController, UIWebViewDelegate {
             }
             var request = URLRequest(url: URL(string:googleSearchURL)!)
             request.allowsCellularAccess = false
-            webView.loadRequest(request)
+            webView.load(request)
         }
     }
     
+    @IBAction func handoffPressed(_ sender: UIBarButtonItem) {
+        HandoffController.shared.handoff(from: webView)
+    }
+    
     @IBAction func backButtonPressed(_ sender: UIButton) {
         if webView.canGoBack{
             webView.goBack()
@@ -0,0 +1,137 @@
+//
+//  WebContentBlocker.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import WebKit
+
+/// Sets up the browser's web views: one process pool for all of them, and a
+/// compiled rule list that keeps ad and tracker requests from loading.
+///
+/// The rules are compiled once and stored by WebKit under a versioned
+/// identifier, so later launches only look them up. Page loads are timed
+/// with and without blocking, along with the size of what the media
+/// extractor had to read from each page. Main thread only.
+final class WebContentBlocker {
+
+    static let shared = WebContentBlocker()
+
+    /// Shared so every web view reuses one web content process and its caches.
+    static let processPool = WKProcessPool()
+
+    private static let ruleListIdentifier = "AdsAndTrackers-1"
+
+    /// Blocked when loaded by a page on another domain, which is how they
+    /// turn up; nothing a video itself is served from.
+    private static let blockedDomains = [
+        "doubleclick.net", "googlesyndication.com", "googleadservices.com", "google-analytics.com",
+        "googletagmanager.com", "googletagservices.com", "adservice.google.com", "adnxs.com",
+        "advertising.com", "adsrvr.org", "amazon-adsystem.com", "criteo.com", "criteo.net",
+        "taboola.com", "outbrain.com", "scorecardresearch.com", "quantserve.com", "moatads.com",
+        "rubiconproject.com", "pubmatic.com", "openx.net", "casalemedia.com", "smartadserver.com",
+        "popads.net", "popcash.net", "propellerads.com", "exoclick.com", "juicyads.com",
+        "adsterra.com", "hotjar.com", "mixpanel.com", "chartbeat.com", "facebook.net",
+    ]
+
+    //MARK: Properties
+    /// Turn off to collect unblocked page loads for comparison.
+    var isEnabled = true
+
+    private var ruleList: AnyObject?
+    private var waiting: [WKUserContentController] = []
+    private var compiling = false
+
+    private(set) var blockedPageLoads = LatencyHistogram()
+    private(set) var unblockedPageLoads = LatencyHistogram()
+    private var scannedBytes: [Bool: (total: Int, pages: Int)] = [:]
+
+    //MARK: Methods
+
+    /// A configuration for a browser web view, on the shared process pool.
+    func configuration() -> WKWebViewConfiguration {
+        let configuration = WKWebViewConfiguration()
+        configuration.processPool = WebContentBlocker.processPool
+        // Videos go to the receiver, not to an Apple TV.
+        configuration.allowsAirPlayForMediaPlayback = false
+        if isEnabled {
+            install(in: configuration.userContentController)
+        }
+        return configuration
+    }
+
+    /// Adds the rule list to `controller`, as soon as it has been compiled.
+    /// Pages loaded before then are not filtered.
+    func install(in controller: WKUserContentController) {
+        guard #available(iOS 11.0, *) else {
+            return
+        }
+        if let ruleList = ruleList as? WKContentRuleList {
+            controller.add(ruleList)
+            return
+        }
+        waiting.append(controller)
+        guard !compiling else {
+            return
+        }
+        let store: WKContentRuleListStore = WKContentRuleListStore.default()
+        compiling = true
+        store.lookUpContentRuleList(forIdentifier: WebContentBlocker.ruleListIdentifier) { [weak self] found, _ in
+            if let found = found {
+                self?.didCompile(found)
+                return
+            }
+            // A list that fails to compile leaves pages unfiltered rather than unloadable.
+            store.compileContentRuleList(forIdentifier: WebContentBlocker.ruleListIdentifier, encodedContentRuleList: WebContentBlocker.encodedRules()) { compiled, _ in
+                self?.didCompile(compiled)
+            }
+        }
+    }
+
+    @available(iOS 11.0, *)
+    private func didCompile(_ compiled: WKContentRuleList?) {
+        compiling = false
+        ruleList = compiled
+        if let compiled = compiled {
+            for controller in waiting {
+                controller.add(compiled)
+            }
+        }
+        waiting.removeAll()
+    }
+
+    private static func encodedRules() -> String {
+        let rules: [[String: Any]] = blockedDomains.map { domain in
+            let pattern = "^https?://([^/:]+\\.)?" + NSRegularExpression.escapedPattern(for: domain) + "[/:]"
+            return ["trigger": ["url-filter": pattern, "load-type": ["third-party"]], "action": ["type": "block"]]
+        }
+        let data = (try? JSONSerialization.data(withJSONObject: rules)) ?? Data()
+        return String(data: data, encoding: .utf8) ?? "[]"
+    }
+
+    //MARK: Measuring
+
+    /// Records a page from navigation start to finish, and how many bytes
+    /// the extractor got back from it.
+    func recordPageLoad(_ duration: TimeInterval, scannedBytes bytes: Int) {
+        let blocked = isEnabled && ruleList != nil
+        if blocked {
+            blockedPageLoads.record(duration)
+        } else {
+            unblockedPageLoads.record(duration)
+        }
+        let scanned = scannedBytes[blocked] ?? (0, 0)
+        scannedBytes[blocked] = (scanned.total + bytes, scanned.pages + 1)
+    }
+
+    func statistics() -> [String: Any] {
+        func meanScanned(_ blocked: Bool) -> Int {
+            let scanned = scannedBytes[blocked] ?? (0, 0)
+            return scanned.pages == 0 ? 0 : scanned.total / scanned.pages
+        }
+        return ["blocked_page_load": blockedPageLoads.summary(), "unblocked_page_load": unblockedPageLoads.summary(),
+                "blocked_scanned_bytes": meanScanned(true), "unblocked_scanned_bytes": meanScanned(false)]
+    }
+}
@@ -0,0 +1,101 @@
+//
+//  WebCookieBridge.swift
+//  Cast
+//
+//  Created by Fady Basem on 10/19/26.
+//  Copyright © 2026 Fady Basem Co. All rights reserved.
+//
+
+import WebKit
+
+/// Copies the browser's cookies into `HTTPCookieStorage.shared`, which the
+/// proxy and the prefetcher send with their requests.
+///
+/// WKWebView keeps its cookies in a store of its own. From iOS 11 that store
+/// is mirrored whenever it changes, deletions included. Before iOS 11 it
+/// cannot be read, so cookies are picked up from the web view's navigation
+/// responses and from `document.cookie` once a page has loaded; cookies set
+/// by scripts' own requests with `HttpOnly` are missed there. Main thread only.
+final class WebCookieBridge: NSObject {
+
+    static let shared = WebCookieBridge()
+
+    //MARK: Properties
+    /// What was last copied from the web view's store, to remove what it drops.
+    private var mirrored: [HTTPCookie] = []
+
+    //MARK: Lifecycle
+    func start() {
+        guard #available(iOS 11.0, *) else {
+            return
+        }
+        let store = WKWebsiteDataStore.default().httpCookieStore
+        store.add(self)
+        copyCookies(from: store)
+    }
+
+    @available(iOS 11.0, *)
+    private func copyCookies(from store: WKHTTPCookieStore) {
+        store.getAllCookies { [weak self] cookies in
+            guard let strongSelf = self else {
+                return
+            }
+            let storage = HTTPCookieStorage.shared
+            for cookie in strongSelf.mirrored where !cookies.contains(where: { WebCookieBridge.same($0, cookie) }) {
+                storage.deleteCookie(cookie)
+            }
+            for cookie in cookies {
+                storage.setCookie(cookie)
+            }
+            strongSelf.mirrored = cookies
+        }
+    }
+
+    private static func same(_ a: HTTPCookie, _ b: HTTPCookie) -> Bool {
+        return a.name == b.name && a.domain == b.domain && a.path == b.path
+    }
+
+    //MARK: Before iOS 11
+
+    /// Stores the cookies a navigation response sets.
+    func record(_ response: URLResponse) {
+        guard !WebCookieBridge.mirrorsStore, let response = response as? HTTPURLResponse, let url = response.url,
+            let fields = response.allHeaderFields as? [String: String] else {
+            return
+        }
+        HTTPCookieStorage.shared.setCookies(HTTPCookie.cookies(withResponseHeaderFields: fields, for: url), for: url, mainDocumentURL: nil)
+    }
+
+    /// Stores the `name=value; ...` pairs of a page's `document.cookie`.
+    func record(documentCookie: String, for url: URL) {
+        guard !WebCookieBridge.mirrorsStore, let host = url.host else {
+            return
+        }
+        for pair in documentCookie.components(separatedBy: "; ") {
+            guard let equals = pair.range(of: "=") else {
+                continue
+            }
+            let properties: [HTTPCookiePropertyKey: Any] = [.name: pair.substring(to: equals.lowerBound),
+                                                            .value: pair.substring(from: equals.upperBound),
+                                                            .domain: host, .path: "/", .originURL: url]
+            if let cookie = HTTPCookie(properties: properties) {
+                HTTPCookieStorage.shared.setCookie(cookie)
+            }
+        }
+    }
+
+    private static var mirrorsStore: Bool {
+        if #available(iOS 11.0, *) {
+            return true
+        }
+        return false
+    }
+}
+
+@available(iOS 11.0, *)
+extension WebCookieBridge: WKHTTPCookieStoreObserver {
+
+    func cookiesDidChange(in cookieStore: WKHTTPCookieStore) {
+        copyCookies(from: cookieStore)
+    }
+}
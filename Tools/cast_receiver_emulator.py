@@ -0,0 +1,745 @@
+#!/usr/bin/env python3
+"""Stand-in Cast receiver for benchmarking the control path without a TV.
+
+Speaks the Cast v2 wire protocol: TLS on the Cast port, 4-byte big-endian
+length prefixes and CastMessage protobufs, with the connection, heartbeat,
+receiver and media namespaces. LAUNCH starts a Default Media Receiver whose
+player answers LOAD, PLAY, PAUSE, STOP, SEEK, the QUEUE_* family,
+EDIT_TRACKS_INFO and GET_STATUS, and fans its status out to every sender
+connected to it. Each request type can be given its own latency.
+
+Device authentication cannot be emulated, so the deviceauth challenge is
+answered with an error; the Google Cast SDK therefore refuses the emulator,
+and it is driven by the bundled benchmark client instead. Port 8008 serves
+the eureka_info the app reads for receivers added by address.
+
+    # A receiver on the usual ports, with slow loads.
+    Tools/cast_receiver_emulator.py serve --latency 20 --latency LOAD=400
+
+    # A receiver on a spare port and a benchmark against it, for CI.
+    Tools/cast_receiver_emulator.py bench --iterations 50 --senders 4
+
+Only the Python 3 standard library and the openssl command (for a throwaway
+certificate when none is given) are needed.
+"""
+
+import argparse
+import asyncio
+import http.server
+import itertools
+import json
+import os
+import random
+import socket
+import ssl
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import uuid
+
+NS_CONNECTION = "urn:x-cast:com.google.cast.tp.connection"
+NS_HEARTBEAT = "urn:x-cast:com.google.cast.tp.heartbeat"
+NS_DEVICEAUTH = "urn:x-cast:com.google.cast.tp.deviceauth"
+NS_RECEIVER = "urn:x-cast:com.google.cast.receiver"
+NS_MEDIA = "urn:x-cast:com.google.cast.media"
+
+PLATFORM_ID = "receiver-0"
+DEFAULT_MEDIA_RECEIVER = "CC1AD845"
+MAX_FRAME = 64 * 1024
+# PAUSE, SEEK, STREAM_VOLUME, STREAM_MUTE, QUEUE_NEXT, QUEUE_PREV.
+SUPPORTED_MEDIA_COMMANDS = 1 | 2 | 4 | 8 | 64 | 128
+
+
+# MARK: CastMessage
+
+def _varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def _read_varint(data, offset):
+    value = shift = 0
+    while True:
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, offset
+        shift += 7
+
+
+def _field(number, value):
+    if isinstance(value, int):
+        return _varint(number << 3) + _varint(value)
+    if isinstance(value, str):
+        value = value.encode("utf-8")
+    return _varint(number << 3 | 2) + _varint(len(value)) + value
+
+
+def encode(source, destination, namespace, payload):
+    """A framed CastMessage; `payload` is a dict sent as JSON, or bytes."""
+    binary = isinstance(payload, bytes)
+    body = (_field(1, 0) + _field(2, source) + _field(3, destination) + _field(4, namespace)
+            + _field(5, 1 if binary else 0)
+            + (_field(7, payload) if binary else _field(6, json.dumps(payload, separators=(",", ":")))))
+    return struct.pack(">I", len(body)) + body
+
+
+def decode(body):
+    fields = {}
+    offset = 0
+    while offset < len(body):
+        key, offset = _read_varint(body, offset)
+        number, wire_type = key >> 3, key & 7
+        if wire_type == 0:
+            value, offset = _read_varint(body, offset)
+        elif wire_type == 2:
+            length, offset = _read_varint(body, offset)
+            value = bytes(body[offset:offset + length])
+            offset += length
+        else:
+            raise ValueError("unsupported wire type %d" % wire_type)
+        fields[number] = value
+    message = {
+        "source": fields.get(2, b"").decode("utf-8"),
+        "destination": fields.get(3, b"").decode("utf-8"),
+        "namespace": fields.get(4, b"").decode("utf-8"),
+    }
+    if fields.get(5, 0) == 1:
+        message["payload"] = fields.get(7, b"")
+    else:
+        text = fields.get(6, b"").decode("utf-8")
+        message["payload"] = json.loads(text) if text else {}
+    return message
+
+
+async def read_message(reader):
+    """The next message from `reader`, or None once the peer has closed it."""
+    try:
+        (length,) = struct.unpack(">I", await reader.readexactly(4))
+        if length > MAX_FRAME:
+            raise ValueError("frame of %d bytes" % length)
+        return decode(await reader.readexactly(length))
+    except asyncio.IncompleteReadError:
+        return None
+
+
+# MARK: Latency
+
+class Latency:
+    """Milliseconds per request type, from `300` or `LOAD=300` entries."""
+
+    def __init__(self, entries, jitter_ms=0):
+        self.default = 0.0
+        self.by_type = {}
+        self.jitter = jitter_ms / 1000.0
+        for entry in entries or []:
+            name, _, value = entry.rpartition("=")
+            if name:
+                self.by_type[name.upper()] = float(value) / 1000.0
+            else:
+                self.default = float(value) / 1000.0
+
+    def delay(self, request_type):
+        base = self.by_type.get(request_type, self.default)
+        return max(0.0, base + random.uniform(-self.jitter, self.jitter))
+
+
+# MARK: Receiver
+
+class Receiver:
+    """What the TV would hold: one application, its player and its queue.
+    Lives on the event loop, like everything else here."""
+
+    def __init__(self, name, latency):
+        self.name = name
+        self.udn = str(uuid.uuid4())
+        self.latency = latency
+        self.connections = set()
+        self.volume = {"level": 1.0, "muted": False}
+        self.application = None
+        self.transport_ids = itertools.count(1)
+        self.media_session_ids = itertools.count(1)
+        self.item_ids = itertools.count(1)
+        self.reset_player()
+
+    def reset_player(self):
+        self.media_session_id = None
+        self.items = []
+        self.current_item_id = None
+        self.repeat_mode = "REPEAT_OFF"
+        self.player_state = "IDLE"
+        self.idle_reason = None
+        self.position = 0.0
+        self.position_at = time.monotonic()
+        self.active_track_ids = []
+        self.stream_volume = {"level": 1.0, "muted": False}
+
+    # MARK: Connections
+
+    def later(self, request_type, action):
+        """Runs `action` once the latency configured for `request_type` has passed."""
+        asyncio.get_event_loop().call_later(self.latency.delay(request_type), action)
+
+    def broadcast(self, source, namespace, payload, reply_to=None, request_id=0):
+        """Sends `payload` to every sender connected to `source`. The one that
+        asked gets it with its request ID, the rest with 0."""
+        for connection in list(self.connections):
+            for sender in connection.senders_of(source):
+                answer = dict(payload, requestId=request_id if (connection, sender) == reply_to else 0)
+                connection.send(source, sender, namespace, answer)
+
+    # MARK: Receiver namespace
+
+    def receiver_status(self, request_id=0):
+        applications = []
+        if self.application:
+            applications.append(dict(self.application))
+        return {"type": "RECEIVER_STATUS", "requestId": request_id,
+                "status": {"applications": applications, "volume": dict(self.volume), "isActiveInput": True}}
+
+    def handle_receiver(self, connection, sender, payload):
+        request_type = payload.get("type")
+        request_id = payload.get("requestId", 0)
+        reply_to = (connection, sender)
+
+        def answer():
+            if request_type == "LAUNCH":
+                app_id = payload.get("appId", DEFAULT_MEDIA_RECEIVER)
+                if not self.application or self.application["appId"] != app_id:
+                    self.reset_player()
+                    self.application = {
+                        "appId": app_id, "displayName": "Default Media Receiver", "isIdleScreen": False,
+                        "sessionId": str(uuid.uuid4()), "transportId": "web-%d" % next(self.transport_ids),
+                        "namespaces": [{"name": NS_MEDIA}], "statusText": "Ready To Cast",
+                    }
+            elif request_type == "STOP":
+                self.application = None
+                self.reset_player()
+            elif request_type == "SET_VOLUME":
+                self.volume.update(payload.get("volume", {}))
+            elif request_type == "GET_APP_AVAILABILITY":
+                availability = {app_id: "APP_AVAILABLE" for app_id in payload.get("appId", [])}
+                connection.send(PLATFORM_ID, sender, NS_RECEIVER, {
+                    "type": "GET_APP_AVAILABILITY", "responseType": "GET_APP_AVAILABILITY",
+                    "requestId": request_id, "availability": availability})
+                return
+            elif request_type != "GET_STATUS":
+                connection.send(PLATFORM_ID, sender, NS_RECEIVER,
+                                {"type": "INVALID_REQUEST", "requestId": request_id, "reason": "INVALID_COMMAND"})
+                return
+            status = self.receiver_status()
+            if request_type == "GET_STATUS":
+                connection.send(PLATFORM_ID, sender, NS_RECEIVER, dict(status, requestId=request_id))
+            else:
+                self.broadcast(PLATFORM_ID, NS_RECEIVER, status, reply_to, request_id)
+
+        self.later(request_type, answer)
+
+    # MARK: Media namespace
+
+    def current_time(self):
+        if self.player_state != "PLAYING":
+            return self.position
+        return self.position + time.monotonic() - self.position_at
+
+    def set_position(self, position, state):
+        self.position = max(0.0, position)
+        self.position_at = time.monotonic()
+        self.player_state = state
+
+    def current_item(self):
+        return next((item for item in self.items if item["itemId"] == self.current_item_id), None)
+
+    def jump(self, offset):
+        ids = [item["itemId"] for item in self.items]
+        if self.current_item_id not in ids:
+            return False
+        index = ids.index(self.current_item_id) + offset
+        if self.repeat_mode == "REPEAT_ALL":
+            index %= len(ids)
+        if not 0 <= index < len(ids):
+            return False
+        self.current_item_id = ids[index]
+        self.set_position(self.items[index].get("startTime", 0), "PLAYING")
+        return True
+
+    def advance_if_finished(self):
+        item = self.current_item()
+        duration = item and item.get("media", {}).get("duration") or 0
+        if self.player_state != "PLAYING" or duration <= 0 or self.current_time() < duration:
+            return
+        if self.repeat_mode == "REPEAT_SINGLE":
+            self.set_position(0, "PLAYING")
+        elif not self.jump(1):
+            self.set_position(duration, "IDLE")
+            self.idle_reason = "FINISHED"
+
+    def media_status(self, request_id=0):
+        if self.media_session_id is None:
+            return {"type": "MEDIA_STATUS", "requestId": request_id, "status": []}
+        self.advance_if_finished()
+        item = self.current_item()
+        status = {
+            "mediaSessionId": self.media_session_id, "playbackRate": 1, "playerState": self.player_state,
+            "currentTime": round(self.current_time(), 3), "supportedMediaCommands": SUPPORTED_MEDIA_COMMANDS,
+            "volume": dict(self.stream_volume), "currentItemId": self.current_item_id,
+            "repeatMode": self.repeat_mode, "activeTrackIds": list(self.active_track_ids),
+            "items": [{"itemId": entry["itemId"]} for entry in self.items],
+        }
+        if item:
+            status["media"] = item.get("media", {})
+        if self.idle_reason:
+            status["idleReason"] = self.idle_reason
+        return {"type": "MEDIA_STATUS", "requestId": request_id, "status": [status]}
+
+    def new_items(self, items):
+        return [dict(item, itemId=next(self.item_ids)) for item in items]
+
+    def load_queue(self, items, start_index, position, autoplay):
+        self.media_session_id = next(self.media_session_ids)
+        self.items = self.new_items(items)
+        start_index = min(max(0, start_index), len(self.items) - 1)
+        self.current_item_id = self.items[start_index]["itemId"]
+        self.idle_reason = None
+        self.active_track_ids = []
+        start = position if position is not None else self.items[start_index].get("startTime", 0)
+        self.set_position(start, "PLAYING" if autoplay else "PAUSED")
+
+    def insert(self, items, before):
+        ids = [item["itemId"] for item in self.items]
+        index = ids.index(before) if before in ids else len(self.items)
+        self.items[index:index] = items
+
+    def apply_media(self, request_type, payload):
+        """Changes the player for one request; returns an error reason or None."""
+        if request_type == "LOAD":
+            if "media" not in payload:
+                return "INVALID_PARAMS"
+            self.load_queue([{"media": payload["media"]}], 0, payload.get("currentTime"), payload.get("autoplay", True))
+            self.active_track_ids = payload.get("activeTrackIds", [])
+            return None
+        if request_type == "QUEUE_LOAD":
+            items = payload.get("items") or []
+            if not items:
+                return "INVALID_PARAMS"
+            self.load_queue(items, payload.get("startIndex", 0), payload.get("currentTime"), True)
+            self.repeat_mode = payload.get("repeatMode", "REPEAT_OFF")
+            return None
+        if request_type == "GET_STATUS":
+            return None
+        if self.media_session_id is None or payload.get("mediaSessionId") != self.media_session_id:
+            return "INVALID_MEDIA_SESSION_ID"
+
+        if request_type == "PLAY":
+            self.set_position(self.current_time(), "PLAYING")
+        elif request_type == "PAUSE":
+            self.set_position(self.current_time(), "PAUSED")
+        elif request_type == "STOP":
+            self.set_position(self.current_time(), "IDLE")
+            self.idle_reason = "CANCELLED"
+        elif request_type == "SEEK":
+            resume = payload.get("resumeState")
+            state = {"PLAYBACK_START": "PLAYING", "PLAYBACK_PAUSE": "PAUSED"}.get(resume, self.player_state)
+            position = payload.get("currentTime")
+            if position is None:
+                position = self.current_time() + payload.get("relativeTime", 0)
+            self.set_position(position, state)
+        elif request_type == "SET_VOLUME":
+            self.stream_volume.update(payload.get("volume", {}))
+        elif request_type == "EDIT_TRACKS_INFO":
+            self.active_track_ids = payload.get("activeTrackIds", self.active_track_ids)
+        elif request_type == "QUEUE_INSERT":
+            self.insert(self.new_items(payload.get("items", [])), payload.get("insertBefore"))
+            if payload.get("currentItemIndex") is not None:
+                self.current_item_id = self.items[payload["currentItemIndex"]]["itemId"]
+                self.set_position(payload.get("currentTime", 0), "PLAYING")
+        elif request_type == "QUEUE_REMOVE":
+            removed = set(payload.get("itemIds", []))
+            ids = [item["itemId"] for item in self.items]
+            if self.current_item_id in removed:
+                following = [item_id for item_id in ids[ids.index(self.current_item_id):] if item_id not in removed]
+                self.current_item_id = following[0] if following else None
+                if self.current_item_id is None:
+                    self.set_position(0, "IDLE")
+                    self.idle_reason = "FINISHED"
+                else:
+                    self.set_position(0, "PLAYING")
+            self.items = [item for item in self.items if item["itemId"] not in removed]
+        elif request_type == "QUEUE_REORDER":
+            moved = payload.get("itemIds", [])
+            taken = [item for item in self.items if item["itemId"] in moved]
+            taken.sort(key=lambda item: moved.index(item["itemId"]))
+            self.items = [item for item in self.items if item["itemId"] not in moved]
+            self.insert(taken, payload.get("insertBefore"))
+        elif request_type == "QUEUE_UPDATE":
+            updates = {item.get("itemId"): item for item in payload.get("items", [])}
+            self.items = [dict(item, **updates.get(item["itemId"], {})) for item in self.items]
+            if "repeatMode" in payload:
+                self.repeat_mode = payload["repeatMode"]
+            if payload.get("currentItemId") is not None:
+                self.current_item_id = payload["currentItemId"]
+                self.set_position(payload.get("currentTime", 0), "PLAYING")
+            elif payload.get("jump"):
+                self.jump(payload["jump"])
+        elif request_type in ("QUEUE_NEXT", "QUEUE_PREV"):
+            self.jump(1 if request_type == "QUEUE_NEXT" else -1)
+        else:
+            return "INVALID_COMMAND"
+        return None
+
+    def handle_media(self, connection, sender, transport_id, payload):
+        request_type = payload.get("type")
+        request_id = payload.get("requestId", 0)
+
+        def answer():
+            status = None
+            if request_type == "QUEUE_GET_ITEM_IDS":
+                reply = {"type": "QUEUE_ITEM_IDS", "itemIds": [item["itemId"] for item in self.items]}
+            elif request_type == "QUEUE_GET_ITEMS":
+                wanted = set(payload.get("itemIds", []))
+                reply = {"type": "QUEUE_ITEMS", "items": [item for item in self.items if item["itemId"] in wanted]}
+            else:
+                reason = self.apply_media(request_type, payload)
+                reply = {"type": "INVALID_REQUEST", "reason": reason} if reason else None
+                status = self.media_status()
+            if reply is not None:
+                connection.send(transport_id, sender, NS_MEDIA, dict(reply, requestId=request_id))
+            elif request_type == "GET_STATUS":
+                connection.send(transport_id, sender, NS_MEDIA, dict(status, requestId=request_id))
+            else:
+                self.broadcast(transport_id, NS_MEDIA, status, (connection, sender), request_id)
+
+        self.later(request_type, answer)
+
+
+# MARK: Connections
+
+class Connection:
+    """One TLS socket, carrying any number of virtual connections."""
+
+    def __init__(self, receiver, writer):
+        self.receiver = receiver
+        self.writer = writer
+        self.virtual = set()
+
+    def senders_of(self, destination):
+        return [sender for sender, target in self.virtual if target in (destination, "*")]
+
+    def send(self, source, destination, namespace, payload):
+        if not self.writer.is_closing():
+            self.writer.write(encode(source, destination, namespace, payload))
+
+    def dispatch(self, message):
+        namespace, sender = message["namespace"], message["source"]
+        destination, payload = message["destination"], message["payload"]
+        if namespace == NS_DEVICEAUTH:
+            # DeviceAuthMessage { error: AuthError { error_type: INTERNAL_ERROR } }
+            self.send(destination, sender, NS_DEVICEAUTH, _field(3, _field(1, 0)))
+            return
+        if not isinstance(payload, dict):
+            return
+        if namespace == NS_CONNECTION:
+            if payload.get("type") == "CONNECT":
+                self.virtual.add((sender, destination))
+            elif payload.get("type") == "CLOSE":
+                self.virtual.discard((sender, destination))
+        elif namespace == NS_HEARTBEAT:
+            if payload.get("type") == "PING":
+                self.send(destination, sender, NS_HEARTBEAT, {"type": "PONG"})
+        elif namespace == NS_RECEIVER and destination == PLATFORM_ID:
+            self.receiver.handle_receiver(self, sender, payload)
+        elif namespace == NS_MEDIA:
+            application = self.receiver.application
+            if application and destination == application["transportId"]:
+                self.receiver.handle_media(self, sender, destination, payload)
+
+
+class EurekaHandler(http.server.BaseHTTPRequestHandler):
+    """The bits of the setup API the app reads for receivers added by address."""
+
+    def do_GET(self):
+        if not self.path.startswith("/setup/eureka_info"):
+            self.send_error(404)
+            return
+        receiver = self.server.receiver
+        body = json.dumps({"name": receiver.name, "ssdp_udn": receiver.udn,
+                           "device_info": {"model_name": "Cast Receiver Emulator", "manufacturer": "Cast"}}).encode("utf-8")
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        pass
+
+
+def tls_context(cert, key):
+    """A server context; a throwaway self-signed certificate if none is given."""
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    if not cert:
+        directory = tempfile.mkdtemp(prefix="cast-emulator-")
+        cert, key = os.path.join(directory, "cert.pem"), os.path.join(directory, "key.pem")
+        subprocess.check_call(["openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes", "-days", "2",
+                               "-subj", "/CN=cast-receiver-emulator", "-keyout", key, "-out", cert],
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    context.load_cert_chain(cert, key)
+    return context
+
+
+async def serve(host, port, http_port, receiver, context, heartbeat_timeout):
+    """Starts the receiver on the running loop, and eureka_info on a thread
+    of its own. Returns the Cast server."""
+
+    async def handle(reader, writer):
+        writer.get_extra_info("socket").setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        connection = Connection(receiver, writer)
+        receiver.connections.add(connection)
+        try:
+            while True:
+                message = await asyncio.wait_for(read_message(reader), heartbeat_timeout or None)
+                if message is None:
+                    break
+                connection.dispatch(message)
+        except (OSError, ValueError, asyncio.TimeoutError, asyncio.CancelledError):
+            pass
+        finally:
+            receiver.connections.discard(connection)
+            writer.close()
+
+    server = await asyncio.start_server(handle, host, port, ssl=context)
+    if http_port:
+        setup = http.server.ThreadingHTTPServer((host, http_port), EurekaHandler)
+        setup.receiver = receiver
+        threading.Thread(target=setup.serve_forever, daemon=True).start()
+    return server
+
+
+# MARK: Benchmark client
+
+class Sender:
+    """A sender application as far as the wire is concerned."""
+
+    _ids = itertools.count(1)
+
+    def __init__(self, timeout):
+        self.timeout = timeout
+        self.source = "sender-%d" % next(Sender._ids)
+        self.request_ids = itertools.count(1)
+        self.inbox = asyncio.Queue()
+
+    async def open(self, host, port):
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+        context.check_hostname = False
+        context.verify_mode = ssl.CERT_NONE
+        reader, self.writer = await asyncio.wait_for(asyncio.open_connection(host, port, ssl=context), self.timeout)
+        self.writer.get_extra_info("socket").setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.reading = asyncio.ensure_future(self._read(reader))
+        return self
+
+    async def _read(self, reader):
+        try:
+            while True:
+                message = await read_message(reader)
+                if message is None:
+                    break
+                self.inbox.put_nowait((time.monotonic(), message))
+        except (OSError, ValueError):
+            pass
+
+    def send(self, namespace, destination, payload):
+        self.writer.write(encode(self.source, destination, namespace, payload))
+
+    def connect(self, destination):
+        self.send(NS_CONNECTION, destination, {"type": "CONNECT"})
+
+    async def wait(self, predicate):
+        """The arrival time and message of the first one matching `predicate`."""
+        deadline = time.monotonic() + self.timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            try:
+                arrived, message = await asyncio.wait_for(self.inbox.get(), max(0, remaining))
+            except asyncio.TimeoutError:
+                raise TimeoutError("%s timed out" % self.source)
+            if predicate(message):
+                return arrived, message
+
+    async def request(self, namespace, destination, payload):
+        """Seconds until the reply to `payload`, and the reply."""
+        request_id = next(self.request_ids)
+        started = time.monotonic()
+        self.send(namespace, destination, dict(payload, requestId=request_id))
+        arrived, message = await self.wait(lambda m: isinstance(m["payload"], dict) and m["payload"].get("requestId") == request_id)
+        if message["payload"].get("type") == "INVALID_REQUEST":
+            raise RuntimeError("%s rejected: %s" % (payload["type"], message["payload"].get("reason")))
+        return arrived - started, message["payload"]
+
+    def drain(self):
+        while not self.inbox.empty():
+            self.inbox.get_nowait()
+
+    def close(self):
+        self.reading.cancel()
+        self.writer.close()
+
+
+def summary(samples):
+    """Milliseconds, in the shape LatencyHistogram.summary() reports them."""
+    if not samples:
+        return {"count": 0}
+    ordered = sorted(samples)
+
+    def percentile(p):
+        return ordered[min(len(ordered) - 1, int(round(p / 100.0 * (len(ordered) - 1))))] * 1000
+
+    return {"count": len(ordered), "min_ms": ordered[0] * 1000, "mean_ms": sum(ordered) / len(ordered) * 1000,
+            "p50_ms": percentile(50), "p90_ms": percentile(90), "p99_ms": percentile(99), "max_ms": ordered[-1] * 1000}
+
+
+async def join(host, port, timeout, transport_id):
+    sender = await Sender(timeout).open(host, port)
+    sender.connect(PLATFORM_ID)
+    sender.connect(transport_id)
+    return sender
+
+
+def is_status_at(position):
+    """Matches the media status broadcast after a seek to `position`."""
+    def matches(message):
+        status = message["payload"].get("status") if message["namespace"] == NS_MEDIA else None
+        return bool(status) and abs(status[0].get("currentTime", -1) - position) < 0.5
+    return matches
+
+
+async def benchmark(host, port, iterations, sender_count, timeout):
+    """Times connecting, launching, the media requests, status fan-out to the
+    other senders and reconnecting."""
+    samples = {name: [] for name in ("connect", "launch", "load", "seek", "queue_insert", "queue_update", "get_status",
+                                     "status_fanout", "reconnect")}
+    media = {"contentId": "http://example.com/video.mp4", "contentType": "video/mp4", "streamType": "BUFFERED", "duration": 600}
+
+    started = time.monotonic()
+    primary = await Sender(timeout).open(host, port)
+    primary.connect(PLATFORM_ID)
+    await primary.request(NS_RECEIVER, PLATFORM_ID, {"type": "GET_STATUS"})
+    samples["connect"].append(time.monotonic() - started)
+    elapsed, status = await primary.request(NS_RECEIVER, PLATFORM_ID, {"type": "LAUNCH", "appId": DEFAULT_MEDIA_RECEIVER})
+    samples["launch"].append(elapsed)
+    transport_id = status["status"]["applications"][0]["transportId"]
+    primary.connect(transport_id)
+    others = [await join(host, port, timeout, transport_id) for _ in range(sender_count - 1)]
+
+    try:
+        for _ in range(iterations):
+            elapsed, status = await primary.request(NS_MEDIA, transport_id, {"type": "LOAD", "media": media, "autoplay": False})
+            samples["load"].append(elapsed)
+            session = status["status"][0]["mediaSessionId"]
+
+            for other in others:
+                other.drain()
+            position = round(random.uniform(10, 500))
+            sent = time.monotonic()
+            elapsed, _ = await primary.request(NS_MEDIA, transport_id, {"type": "SEEK", "mediaSessionId": session,
+                                                                        "currentTime": position})
+            samples["seek"].append(elapsed)
+            for other in others:
+                arrived, _ = await other.wait(is_status_at(position))
+                samples["status_fanout"].append(arrived - sent)
+
+            elapsed, _ = await primary.request(NS_MEDIA, transport_id, {"type": "QUEUE_INSERT", "mediaSessionId": session,
+                                                                        "items": [{"media": media}]})
+            samples["queue_insert"].append(elapsed)
+            elapsed, _ = await primary.request(NS_MEDIA, transport_id, {"type": "QUEUE_UPDATE", "mediaSessionId": session,
+                                                                        "jump": 1})
+            samples["queue_update"].append(elapsed)
+            elapsed, _ = await primary.request(NS_MEDIA, transport_id, {"type": "GET_STATUS"})
+            samples["get_status"].append(elapsed)
+
+            # Drop the primary connection and time until it controls the media again.
+            primary.close()
+            started = time.monotonic()
+            primary = await join(host, port, timeout, transport_id)
+            await primary.request(NS_MEDIA, transport_id, {"type": "GET_STATUS"})
+            samples["reconnect"].append(time.monotonic() - started)
+    finally:
+        primary.close()
+        for other in others:
+            other.close()
+    return {name: summary(values) for name, values in samples.items()}
+
+
+# MARK: Command line
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    commands = parser.add_subparsers(dest="command")
+    commands.required = True
+
+    server_options = argparse.ArgumentParser(add_help=False)
+    server_options.add_argument("--latency", action="append", metavar="[TYPE=]MS",
+                                help="reply latency in milliseconds, for all requests or one type; repeatable")
+    server_options.add_argument("--jitter", type=float, default=0, metavar="MS", help="uniform jitter added to every latency")
+    server_options.add_argument("--name", default="Cast Receiver Emulator", help="friendly name in eureka_info")
+    server_options.add_argument("--cert", help="PEM certificate; a self-signed one is made if omitted")
+    server_options.add_argument("--key", help="PEM private key for --cert")
+    server_options.add_argument("--heartbeat-timeout", type=float, default=15,
+                                help="seconds of silence before a sender is dropped; 0 to never drop")
+
+    serve_parser = commands.add_parser("serve", parents=[server_options], help="run a receiver until interrupted")
+    serve_parser.add_argument("--host", default="0.0.0.0")
+    serve_parser.add_argument("--port", type=int, default=8009)
+    serve_parser.add_argument("--http-port", type=int, default=8008, help="eureka_info port; 0 to turn off")
+
+    bench_parser = commands.add_parser("bench", parents=[server_options],
+                                       help="benchmark a receiver, starting one on a spare port unless --target is given")
+    bench_parser.add_argument("--target", metavar="HOST:PORT", help="an emulator that is already running")
+    bench_parser.add_argument("--iterations", type=int, default=20)
+    bench_parser.add_argument("--senders", type=int, default=3, help="senders connected to the media session")
+    bench_parser.add_argument("--timeout", type=float, default=10, help="seconds to wait for any one reply")
+
+    arguments = parser.parse_args()
+    receiver = Receiver(arguments.name, Latency(arguments.latency, arguments.jitter))
+    try:
+        return asyncio.run(run(arguments, receiver))
+    except KeyboardInterrupt:
+        return 0
+
+
+async def run(arguments, receiver):
+    if arguments.command == "serve":
+        server = await serve(arguments.host, arguments.port, arguments.http_port, receiver,
+                             tls_context(arguments.cert, arguments.key), arguments.heartbeat_timeout)
+        print("Cast receiver emulator on %s:%d" % server.sockets[0].getsockname()[:2], file=sys.stderr)
+        await server.serve_forever()
+        return 0
+
+    if arguments.target:
+        host, _, port = arguments.target.rpartition(":")
+        host, port = host or "127.0.0.1", int(port)
+    else:
+        server = await serve("127.0.0.1", 0, 0, receiver, tls_context(arguments.cert, arguments.key),
+                             arguments.heartbeat_timeout)
+        host, port = server.sockets[0].getsockname()[:2]
+    try:
+        results = await benchmark(host, port, arguments.iterations, max(1, arguments.senders), arguments.timeout)
+    except (OSError, RuntimeError) as error:
+        print("benchmark failed: %s" % error, file=sys.stderr)
+        return 1
+    print(json.dumps(results, indent=2, sort_keys=True))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())